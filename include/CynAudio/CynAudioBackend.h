@@ -0,0 +1,125 @@
+/*
+ * Except where otherwise noted, Cynthasine  2024 by https://github.com/h2see is licensed under Creative
+ * Commons Attribution-NonCommercial-ShareAlike 4.0 International. To view a
+ * copy of this license, visit https://creativecommons.org/licenses/by-nc-sa/4.0/
+ */
+
+#ifndef CYN_AUDIO_BACKEND_H
+#define CYN_AUDIO_BACKEND_H
+
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace Cyn {
+
+    // Where a Player's audio goes. The backend pulls interleaved buffers from the player's callback
+    // until it returns false, then reports the end of playback through on_finished.
+    class AudioBackend {
+    public:
+        // Fills num_frames interleaved frames into output, returns false once playback is complete.
+        using Callback = std::function<bool(float* output, size_t num_frames)>;
+
+        virtual ~AudioBackend() = default;
+
+        virtual bool open(int channel_count, double sample_rate, Callback callback, std::function<void()> on_finished) = 0;
+        virtual bool start() = 0;
+        virtual bool stop() = 0;
+        virtual void close() = 0;
+
+        // The rate open() should be given for audio at sample_rate: sample_rate itself when the output supports it,
+        // otherwise the rate the player resamples to. Called before open().
+        virtual double supported_sample_rate(int /*channel_count*/, double sample_rate) { return sample_rate; }
+
+        // A real-time backend calls back from an audio thread that must never block. Other backends call back
+        // from an ordinary thread, so the player may wait there for queued data instead of playing silence.
+        virtual bool is_realtime() const { return true; }
+    };
+
+    // Receives the buffers rendered by an offline backend.
+    class AudioSink {
+    public:
+        virtual ~AudioSink() = default;
+
+        virtual void open(int /*channel_count*/, double /*sample_rate*/) {}
+        virtual void write(const float* frames, size_t num_frames) = 0;
+        // Called when a playback run ends.
+        virtual void flush() {}
+    };
+
+    // Keeps every rendered frame in memory.
+    class MemorySink : public AudioSink {
+    public:
+        void open(int channel_count, double sample_rate) override;
+        void write(const float* frames, size_t num_frames) override;
+
+        const std::vector<float>& samples() const { return sink_samples; }
+        int channel_count() const { return sink_channel_count; }
+        void clear() { sink_samples.clear(); }
+
+    private:
+        std::vector<float> sink_samples; // Interleaved frames
+        int sink_channel_count = 1;
+    };
+
+    // Writes 16-bit PCM WAV, the header is completed on every flush.
+    class WavSink : public AudioSink {
+    public:
+        explicit WavSink(const std::filesystem::path& filename);
+        ~WavSink() override;
+
+        void open(int channel_count, double sample_rate) override;
+        void write(const float* frames, size_t num_frames) override;
+        void flush() override;
+
+    private:
+        void write_header();
+
+        std::filesystem::path filename;
+        std::ofstream file;
+        std::vector<char> buffer;
+        int sink_channel_count = 1;
+        double sink_sample_rate = 44100.0;
+        size_t num_frames_written = 0;
+    };
+
+    // Discards the audio and measures how fast it was produced.
+    class NullSink : public AudioSink {
+    public:
+        void open(int channel_count, double sample_rate) override;
+        void write(const float* frames, size_t num_frames) override;
+        void flush() override;
+
+        size_t num_frames() const { return num_frames_written; }
+        size_t num_blocks() const { return num_blocks_written; }
+        // Wall time from the first write of the last run to its flush.
+        double elapsed() const { return elapsed_seconds; }
+        // Seconds of audio produced per second of wall time.
+        double realtime_factor() const;
+
+    private:
+        double sink_sample_rate = 44100.0;
+        size_t num_frames_written = 0;
+        size_t num_blocks_written = 0;
+        size_t num_run_frames = 0;
+        double elapsed_seconds = 0.0;
+        std::optional<std::chrono::steady_clock::time_point> run_start;
+    };
+
+    // Plays through PortAudio on the given (or default) output device. PortAudio stays initialized while any of these backends exists.
+    // Rates the device rejects are played at its default sample rate.
+    std::unique_ptr<AudioBackend> portaudio_backend(std::optional<int> device_index = std::nullopt);
+
+    // Drives the player's callback on its own thread in blocks of block_size frames and hands every block to sink.
+    // speed is a multiple of real time, 0 renders as fast as possible. The last block may end in silence.
+    // Renders at sample_rate when given, resampling from the player's rate, and at the player's rate otherwise.
+    std::unique_ptr<AudioBackend> offline_backend(std::shared_ptr<AudioSink> sink, size_t block_size = 512, double speed = 0.0, std::optional<double> sample_rate = std::nullopt);
+
+} // namespace Cyn
+
+#endif // CYN_AUDIO_BACKEND_H
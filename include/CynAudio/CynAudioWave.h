@@ -15,6 +15,60 @@
 #endif // CYN_WAVE_ARRAY_ADDON
 
 #include "CynWave.h"
+#include "CynWaveVoice.hpp"
+
+namespace Cyn {
+
+	/**
+	 * @brief Schedules a WaveArray on the player for the configured sample rate, rendered in the audio callback.
+	 *
+	 * Nothing is rendered up front: a WaveVoice synthesizes the waves block by block while playing, so memory is
+	 * bounded by the voices sounding at once rather than by the length of the piece. Waves above the Nyquist
+	 * frequency are dropped and the samples are not rescaled.
+	 *
+	 * @tparam WaveT The floating point type of the waves.
+	 * @param waves The waves to play.
+	 * @param start_time When to start, in seconds after playback starts.
+	 * @param duration How long to play, in seconds.
+	 * @param fade Raised cosine fade in and out, in seconds.
+	 */
+	template<NumF WaveT>
+	inline void schedule_audio(const WaveArray<WaveT>& waves, WaveT start_time, WaveT duration, WaveT fade = static_cast<WaveT>(0)) {
+		WaveT sample_rate = WaveArray<WaveT>::SAMPLE_RATE;
+		WaveArray<WaveT>::player().schedule_voice(std::make_unique<WaveVoice<WaveT>>(waves, sample_rate, duration, fade), start_time);
+	}
+
+	/**
+	 * @brief Queues the next duration seconds of a WaveStream on the player for the configured sample rate.
+	 *
+	 * The stream is rendered and handed to the player one block at a time, so no full length render or timestamp
+	 * array is ever allocated. Unlike WaveArray::queue_audio, the samples are not filtered or rescaled.
+	 *
+	 * @tparam WaveT The floating point type of the stream.
+	 * @param stream The stream to render from, it advances by the queued samples.
+	 * @param duration The duration to queue in seconds.
+	 *
+	 * @throw std::invalid_argument If the stream's sample rate differs from WaveArray<WaveT>::SAMPLE_RATE.
+	 */
+	template<NumF WaveT>
+	inline void queue_audio(WaveStream<WaveT>& stream, WaveT duration) {
+		if (!isclose(stream.sample_rate(), WaveArray<WaveT>::SAMPLE_RATE, WaveArray<WaveT>::TOLERANCE)) {
+			throw std::invalid_argument("The stream's sample rate must match WaveArray::SAMPLE_RATE.");
+		}
+		Player& player = WaveArray<WaveT>::player();
+		stream.pump(WaveArray<WaveT>::num_timestamps(duration, stream.sample_rate()), [&](const Eigen::ArrayX<WaveT>& block) {
+				if constexpr (std::is_same_v<WaveT, float>) {
+					player.add_samples(std::span<const float>(block.data(), static_cast<size_t>(block.size())));
+				}
+				else {
+					std::vector<float> block_samples(block.data(), block.data() + block.size());
+					player.add_samples(std::move(block_samples));
+				}
+			}
+		);
+	}
+
+} // namespace Cyn
 
 
 #endif // CYN_AUDIO_WAVE_H
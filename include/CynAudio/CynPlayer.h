@@ -7,7 +7,11 @@
 #ifndef CYN_PLAYER_H
 #define CYN_PLAYER_H
 
+#include "CynAudioBackend.h"
+
+#include <cstddef>
 #include <optional>
+#include <span>
 #include <vector>
 #include <memory>
 
@@ -15,6 +19,23 @@ namespace Cyn {
 
     void sleep(double duration);
 
+    // A sound rendered on demand inside the audio callback (pull mode).
+    // render() runs on the real-time thread, so it must not block or allocate.
+    class Voice {
+    public:
+        virtual ~Voice() = default;
+
+        // Called off the real-time thread before the first render() with the rate the voice is rendered at,
+        // which differs from the player's sample rate when the output resamples.
+        virtual void set_sample_rate(double /*sample_rate*/) {}
+
+        // Adds the next num_frames frames into the interleaved output (channel_count values per frame).
+        // Returns false once the voice has finished; later calls must add nothing and keep returning false.
+        virtual bool render(float* output, size_t num_frames, int channel_count) = 0;
+    };
+
+    // Plays through backend, or through PortAudio on the default output device when no backend is given.
+    // Nothing is opened until the first start(), so constructing a player never touches the audio devices.
     class Player {
     public:
         // Constructor for stereo playback (left and right channels).
@@ -22,20 +43,22 @@ namespace Cyn {
             const std::vector<float>& right_channel_samples,
             std::optional<double> duration = std::nullopt,
             double sample_rate = 44100.0,
-            bool do_loop = false
+            bool do_loop = false,
+            std::unique_ptr<AudioBackend> backend = nullptr
             );
 
         // Constructor for mono playback (single channel).
         Player(const std::vector<float>& samples,
             std::optional<double> duration = std::nullopt,
             double sample_rate = 44100.0,
-            bool do_loop = false
+            bool do_loop = false,
+            std::unique_ptr<AudioBackend> backend = nullptr
             );
 
         // Destructor
         ~Player();
 
-        // Start playback of the audio samples.
+        // Start playback of the audio samples. Opens the backend on first use and returns false if it cannot be opened.
         bool start();
 
         // Stop playback of the audio samples.
@@ -47,17 +70,53 @@ namespace Cyn {
         // Play the audio samples (start playback and block until finished).
         bool play();
 
+        // Queued audio is kept as one chunk per call. Vectors passed as rvalues are moved into the queue,
+        // everything else is copied once. Unless looping, chunks are released once played, so queued audio plays once
+        // and a later start() continues with whatever was not played yet.
         void add_samples(const std::vector<float>& samples);
+        void add_samples(std::vector<float>&& samples);
+        void add_samples(std::span<const float> samples);
         void add_samples(const std::vector<float>& left_channel_samples, const std::vector<float>& right_channel_samples);
+        void add_samples(std::span<const float> left_channel_samples, std::span<const float> right_channel_samples);
+
+        // Queues frames already interleaved for the player's channel count, taking ownership of them.
+        void add_interleaved_samples(std::vector<float>&& frames);
+
+        // Queues duration seconds of silence, nothing is stored for it.
+        void add_silence(double duration);
+
         void clear_samples();
 
+        // Schedules a voice to start start_time seconds after playback starts. Voices are rendered
+        // block by block in the audio callback and mixed over the queued samples, then released when finished.
+        // Voices still scheduled when playback stops are discarded.
+        void schedule_voice(std::unique_ptr<Voice> voice, double start_time = 0.0);
+
+        // Number of callbacks since the last start() that ran out of queued samples and played silence.
+        size_t num_underruns() const;
+
+        // Frames still held in the queue, including silence.
+        size_t num_queued_frames() const;
+
+        // Rate of the queued samples, every time in seconds refers to this rate.
+        double sample_rate() const;
+
+        // Rate the backend plays at. Queued samples are resampled to it when it differs from sample_rate().
+        // Equals sample_rate() until the first start() has opened the backend.
+        double output_sample_rate() const;
+
     private:
         class Impl;
         std::unique_ptr<Impl> pImpl; // Pointer to implementation
     };
 
-    extern Cyn::Player player_44100;
-    extern Cyn::Player player_44800;
+    // Shared mono player for the given sample rate, created on first request and kept until the program exits.
+    // Rates are rounded to whole Hz, the player runs at the rounded rate.
+    Player& get_player(double sample_rate);
+
+    // Kept for code written against the former global players
+    [[deprecated("Use get_player(44100.0)")]] extern Player& player_44100;
+    [[deprecated("Use get_player(48000.0)")]] extern Player& player_44800;
 
 } // namespace Cyn
 
@@ -13,6 +13,23 @@ namespace Cyn {
 
 	namespace FFT {
 
+		/**
+		 * @brief Reusable FFT state: plans cached per (size, transform, precision) and caller buffer transforms.
+		 *
+		 * Plans are built on first use of a size and shared afterwards, so loops over equal length frames only
+		 * plan once. r2c(in, out) and c2c(in, out) write into caller owned arrays that are only reallocated when
+		 * their size changes, and c2c_inplace transforms without any output array. A context is safe to share
+		 * across threads.
+		 */
+		using Context = impl::FFTContext;
+
+		/**
+		 * @brief Returns the process wide context used by r2c and c2c.
+		 */
+		inline Context& default_context() {
+			return impl::default_fft_context();
+		}
+
 		/**
 		 * @brief Performs a 1D real-to-complex Fourier transform on an Eigen array.
 		 *
@@ -44,6 +61,61 @@ namespace Cyn {
 			return impl::c2c(ArrayX_NumC, do_inverse, num_threads);
 		}
 
+		/**
+		 * @brief Performs a batched 1D real-to-complex Fourier transform of every column of an Eigen 2D array.
+		 *
+		 * All columns are transformed in one PocketFFT call, which spreads them over num_threads threads.
+		 * Blocks and maps with any strides are accepted as long as they have direct access to their data.
+		 *
+		 * @tparam Derived A template parameter derived from Eigen::ArrayBase.
+		 *
+		 * @param ArrayXX_NumF The input Eigen 2D array of real numbers, one frame per column.
+		 * @param do_inverse If true, performs the inverse transform. Defaults to false.
+		 * @param num_threads Number of threads to use for computation. Defaults to 1.
+		 *
+		 * @return An Eigen::ArrayXX<std::complex<T>> with rows() / 2 + 1 rows holding each column's transform.
+		 */
+		template <typename Derived>
+		inline auto r2c_columns(const Eigen::ArrayBase<Derived>& ArrayXX_NumF, bool do_inverse = false, const size_t& num_threads = 1) {
+			return impl::r2c_axis(ArrayXX_NumF, 0, do_inverse, num_threads);
+		}
+
+		/**
+		 * @brief Performs a batched 1D real-to-complex Fourier transform of every row of an Eigen 2D array.
+		 *
+		 * @see r2c_columns
+		 *
+		 * @return An Eigen::ArrayXX<std::complex<T>> with cols() / 2 + 1 columns holding each row's transform.
+		 */
+		template <typename Derived>
+		inline auto r2c_rows(const Eigen::ArrayBase<Derived>& ArrayXX_NumF, bool do_inverse = false, const size_t& num_threads = 1) {
+			return impl::r2c_axis(ArrayXX_NumF, 1, do_inverse, num_threads);
+		}
+
+		/**
+		 * @brief Performs a batched 1D complex-to-complex Fourier transform of every column of an Eigen 2D array.
+		 *
+		 * @see r2c_columns
+		 *
+		 * @return An Eigen::ArrayXX<std::complex<T>> of the same shape holding each column's transform.
+		 */
+		template <typename Derived>
+		inline auto c2c_columns(const Eigen::ArrayBase<Derived>& ArrayXX_NumC, bool do_inverse = false, const size_t& num_threads = 1) {
+			return impl::c2c_axis(ArrayXX_NumC, 0, do_inverse, num_threads);
+		}
+
+		/**
+		 * @brief Performs a batched 1D complex-to-complex Fourier transform of every row of an Eigen 2D array.
+		 *
+		 * @see r2c_columns
+		 *
+		 * @return An Eigen::ArrayXX<std::complex<T>> of the same shape holding each row's transform.
+		 */
+		template <typename Derived>
+		inline auto c2c_rows(const Eigen::ArrayBase<Derived>& ArrayXX_NumC, bool do_inverse = false, const size_t& num_threads = 1) {
+			return impl::c2c_axis(ArrayXX_NumC, 1, do_inverse, num_threads);
+		}
+
 	} // namespace FFT
 
 	/**
@@ -14,7 +14,7 @@
 namespace Cyn {
 
 	// Intitially set to: 1e-3
-	double DEFAULT_TOLERANCE = 1e-3;
+	inline double DEFAULT_TOLERANCE = 1e-3;
 
 	template <typename T>
 	concept NumA = std::is_arithmetic_v<T>;
@@ -125,6 +125,41 @@ namespace Cyn {
 		return impl::lcm(a, b);
 	}
 
+	/**
+	 * @brief Compute the approximate greatest common divisor of two real numbers.
+	 *
+	 * Runs the Euclidean algorithm on |a| and |b|, treating any remainder within tolerance of zero
+	 * (or of the divisor) as an exact division.
+	 *
+	 * @param a First floating point number.
+	 * @param b Second floating point number.
+	 * @param tolerance Remainders smaller than this are considered zero.
+	 * 
+	 * @return T Returns the largest g (up to tolerance) such that a and b are both integer multiples of g.
+	 */
+	template<NumF T>
+	inline T approx_gcd(T a, T b, T tolerance) {
+		return impl::approx_gcd(a, b, tolerance);
+	}
+
+	/**
+	 * @brief Approximate a non-negative real number by a fraction.
+	 *
+	 * Walks the continued fraction convergents of x and returns the first one within tolerance of it,
+	 * which is also the one with the smallest denominator.
+	 *
+	 * @param x Non-negative floating point number.
+	 * @param tolerance Largest accepted distance between x and the fraction.
+	 * @param max_denominator Convergents with a larger denominator are not considered.
+	 * 
+	 * @return std::optional<std::pair<uint64_t, uint64_t>> Returns the numerator and denominator, or std::nullopt if
+	 * no convergent within tolerance has a denominator of at most max_denominator (or x is negative or not finite).
+	 */
+	template<NumF T>
+	inline std::optional<std::pair<uint64_t, uint64_t>> rationalize(T x, T tolerance, uint64_t max_denominator) {
+		return impl::rationalize(x, tolerance, max_denominator);
+	}
+
 	// ========================================================================
 
 	/**
@@ -8,6 +8,10 @@
 #define CYN_WAVE_H
 
 #include "CynWave.hpp"
+#include "CynWaveAnalyzer.hpp"
+#include "CynWaveExpr.hpp"
+#include "CynWaveSequence.hpp"
+#include "CynWaveStream.hpp"
 
 namespace Cyn {
 
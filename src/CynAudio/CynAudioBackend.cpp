@@ -0,0 +1,360 @@
+/*
+ * Except where otherwise noted, Cynthasine  2024 by https://github.com/h2see is licensed under Creative
+ * Commons Attribution-NonCommercial-ShareAlike 4.0 International. To view a
+ * copy of this license, visit https://creativecommons.org/licenses/by-nc-sa/4.0/
+ */
+
+#include "CynAudioBackend.h"
+
+#include "portaudio.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace Cyn {
+
+    class ScopedPaHandler {
+    public:
+        ScopedPaHandler() : _result(Pa_Initialize()) {}
+        ~ScopedPaHandler() {
+            if (_result == paNoError) {
+                Pa_Terminate();
+            }
+        }
+        PaError result() const { return _result; }
+    private:
+        PaError _result;
+    };
+
+    // PortAudio is initialized when the first backend is created and terminated when the last one is destroyed,
+    // so binaries that never play audio never probe the audio devices.
+    static std::shared_ptr<ScopedPaHandler> acquirePaHandler() {
+        static std::mutex handler_mutex;
+        static std::weak_ptr<ScopedPaHandler> shared_handler;
+        std::lock_guard<std::mutex> lock(handler_mutex);
+        std::shared_ptr<ScopedPaHandler> handler = shared_handler.lock();
+        if (!handler) {
+            handler = std::make_shared<ScopedPaHandler>();
+            shared_handler = handler;
+        }
+        return handler;
+    }
+
+    class PortAudioBackend : public AudioBackend {
+    public:
+        explicit PortAudioBackend(std::optional<int> device_index);
+        ~PortAudioBackend() override;
+
+        double supported_sample_rate(int channel_count, double sample_rate) override;
+        bool open(int channel_count, double sample_rate, Callback callback, std::function<void()> on_finished) override;
+        bool start() override;
+        bool stop() override;
+        void close() override;
+
+    private:
+        std::optional<PaStreamParameters> output_parameters(int channel_count) const;
+
+        std::shared_ptr<ScopedPaHandler> paHandler;
+        PaStream* stream = nullptr;
+        std::optional<int> device_index;
+        Callback callback;
+        std::function<void()> on_finished;
+
+        static int paCallback(const void* inputBuffer, void* outputBuffer, unsigned long framesPerBuffer, const PaStreamCallbackTimeInfo* timeInfo, PaStreamCallbackFlags statusFlags, void* userData);
+        static void paStreamFinished(void* userData);
+    };
+
+    PortAudioBackend::PortAudioBackend(std::optional<int> device_index) : paHandler(acquirePaHandler()), device_index(device_index) {
+        if (paHandler->result() != paNoError) {
+            throw std::runtime_error("Failed to initialize PortAudio: " + std::string(Pa_GetErrorText(paHandler->result())));
+        }
+    }
+
+    PortAudioBackend::~PortAudioBackend() {
+        close();
+    }
+
+    std::optional<PaStreamParameters> PortAudioBackend::output_parameters(int channel_count) const {
+        PaStreamParameters outputParameters = {};
+        outputParameters.device = device_index.value_or(Pa_GetDefaultOutputDevice());
+        if (outputParameters.device == paNoDevice) return std::nullopt;
+
+        outputParameters.channelCount = channel_count;
+        outputParameters.sampleFormat = paFloat32;
+        outputParameters.suggestedLatency = Pa_GetDeviceInfo(outputParameters.device)->defaultLowOutputLatency;
+        return outputParameters;
+    }
+
+    double PortAudioBackend::supported_sample_rate(int channel_count, double sample_rate) {
+        std::optional<PaStreamParameters> outputParameters = output_parameters(channel_count);
+        if (!outputParameters) return sample_rate;
+        if (Pa_IsFormatSupported(nullptr, &outputParameters.value(), sample_rate) == paFormatIsSupported) return sample_rate;
+        return Pa_GetDeviceInfo(outputParameters->device)->defaultSampleRate;
+    }
+
+    bool PortAudioBackend::open(int channel_count, double sample_rate, Callback callback, std::function<void()> on_finished) {
+        close();
+        this->callback = std::move(callback);
+        this->on_finished = std::move(on_finished);
+
+        std::optional<PaStreamParameters> outputParameters = output_parameters(channel_count);
+        if (!outputParameters) return false;
+
+        PaError err = Pa_OpenStream(
+            &stream,
+            nullptr,
+            &outputParameters.value(),
+            sample_rate,
+            paFramesPerBufferUnspecified,
+            paNoFlag,
+            &PortAudioBackend::paCallback,
+            this
+        );
+
+        if (err == paNoError) {
+            err = Pa_SetStreamFinishedCallback(stream, &PortAudioBackend::paStreamFinished);
+        }
+
+        if (err != paNoError) {
+            Pa_CloseStream(stream);
+            stream = nullptr;
+            return false;
+        }
+
+        return true;
+    }
+
+    bool PortAudioBackend::start() {
+        return stream && Pa_StartStream(stream) == paNoError;
+    }
+
+    bool PortAudioBackend::stop() {
+        return stream && Pa_StopStream(stream) == paNoError;
+    }
+
+    void PortAudioBackend::close() {
+        if (!stream) return;
+        Pa_CloseStream(stream);
+        stream = nullptr;
+    }
+
+    int PortAudioBackend::paCallback(const void*, void* outputBuffer,
+        unsigned long framesPerBuffer,
+        const PaStreamCallbackTimeInfo*,
+        PaStreamCallbackFlags, void* userData) {
+        PortAudioBackend* backend = static_cast<PortAudioBackend*>(userData);
+        return backend->callback(static_cast<float*>(outputBuffer), framesPerBuffer) ? paContinue : paComplete;
+    }
+
+    void PortAudioBackend::paStreamFinished(void* userData) {
+        PortAudioBackend* backend = static_cast<PortAudioBackend*>(userData);
+        if (backend->on_finished) backend->on_finished();
+    }
+
+    std::unique_ptr<AudioBackend> portaudio_backend(std::optional<int> device_index) {
+        return std::make_unique<PortAudioBackend>(device_index);
+    }
+
+    class OfflineBackend : public AudioBackend {
+    public:
+        OfflineBackend(std::shared_ptr<AudioSink> sink, size_t block_size, double speed, std::optional<double> output_rate);
+        ~OfflineBackend() override;
+
+        double supported_sample_rate(int, double sample_rate) override { return output_rate.value_or(sample_rate); }
+        bool open(int channel_count, double sample_rate, Callback callback, std::function<void()> on_finished) override;
+        bool start() override;
+        bool stop() override;
+        void close() override;
+        bool is_realtime() const override { return false; }
+
+    private:
+        void run();
+
+        std::shared_ptr<AudioSink> sink;
+        size_t block_size;
+        double speed;
+        std::optional<double> output_rate;
+        int channel_count = 1;
+        double sample_rate = 44100.0;
+        Callback callback;
+        std::function<void()> on_finished;
+        std::vector<float> buffer;
+        std::thread worker;
+        std::atomic<bool> running = false;
+    };
+
+    OfflineBackend::OfflineBackend(std::shared_ptr<AudioSink> sink, size_t block_size, double speed, std::optional<double> output_rate)
+        : sink(std::move(sink)), block_size(block_size), speed(speed), output_rate(output_rate) {
+        if (!this->sink) {
+            throw std::invalid_argument("Offline backend requires a sink.");
+        }
+        if (block_size == 0) {
+            throw std::invalid_argument("Block size must be positive.");
+        }
+        if (output_rate && !(output_rate.value() > 0)) {
+            throw std::invalid_argument("Sample rate must be positive.");
+        }
+    }
+
+    OfflineBackend::~OfflineBackend() {
+        close();
+    }
+
+    bool OfflineBackend::open(int channel_count, double sample_rate, Callback callback, std::function<void()> on_finished) {
+        this->channel_count = channel_count;
+        this->sample_rate = sample_rate;
+        this->callback = std::move(callback);
+        this->on_finished = std::move(on_finished);
+        buffer.assign(block_size * channel_count, 0.0f);
+        sink->open(channel_count, sample_rate);
+        return true;
+    }
+
+    bool OfflineBackend::start() {
+        if (running || !callback) return false;
+        if (worker.joinable()) worker.join();
+        running = true;
+        worker = std::thread(&OfflineBackend::run, this);
+        return true;
+    }
+
+    bool OfflineBackend::stop() {
+        if (!worker.joinable()) return false;
+        running = false;
+        worker.join();
+        return true;
+    }
+
+    void OfflineBackend::close() {
+        stop();
+    }
+
+    void OfflineBackend::run() {
+        auto run_start = std::chrono::steady_clock::now();
+        size_t num_frames = 0;
+        while (running) {
+            bool is_playing = callback(buffer.data(), block_size);
+            sink->write(buffer.data(), block_size);
+            num_frames += block_size;
+            if (!is_playing) break;
+            if (speed > 0) {
+                std::this_thread::sleep_until(run_start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(num_frames / (sample_rate * speed))));
+            }
+        }
+        sink->flush();
+        running = false;
+        if (on_finished) on_finished();
+    }
+
+    std::unique_ptr<AudioBackend> offline_backend(std::shared_ptr<AudioSink> sink, size_t block_size, double speed, std::optional<double> sample_rate) {
+        return std::make_unique<OfflineBackend>(std::move(sink), block_size, speed, sample_rate);
+    }
+
+    // Memory Sink
+
+    void MemorySink::open(int channel_count, double) {
+        sink_channel_count = channel_count;
+    }
+
+    void MemorySink::write(const float* frames, size_t num_frames) {
+        sink_samples.insert(sink_samples.end(), frames, frames + num_frames * sink_channel_count);
+    }
+
+    // WAV Sink
+
+    WavSink::WavSink(const std::filesystem::path& filename) : filename(filename) {
+        file.open(filename, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to open file: " + filename.string());
+        }
+        write_header();
+    }
+
+    WavSink::~WavSink() {
+        flush();
+    }
+
+    void WavSink::open(int channel_count, double sample_rate) {
+        sink_channel_count = channel_count;
+        sink_sample_rate = sample_rate;
+        write_header();
+    }
+
+    void WavSink::write(const float* frames, size_t num_frames) {
+        size_t num_values = num_frames * sink_channel_count;
+        buffer.resize(2 * num_values);
+        for (size_t i = 0; i < num_values; ++i) {
+            int16_t value = static_cast<int16_t>(std::lround(std::clamp(frames[i], -1.0f, 1.0f) * 32767.0f));
+            buffer[2 * i] = static_cast<char>(value & 0xff);
+            buffer[2 * i + 1] = static_cast<char>((value >> 8) & 0xff);
+        }
+        file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        num_frames_written += num_frames;
+    }
+
+    void WavSink::flush() {
+        if (!file.is_open()) return;
+        write_header();
+        file.flush();
+    }
+
+    // Rewrites the 44 byte header in place, then returns to the end of the data
+    void WavSink::write_header() {
+        auto put = [&](uint32_t value, int num_bytes) {
+            for (int i = 0; i < num_bytes; ++i) {
+                file.put(static_cast<char>((value >> (8 * i)) & 0xff));
+            }
+        };
+        uint32_t data_size = static_cast<uint32_t>(num_frames_written * sink_channel_count * 2);
+        uint32_t rate = static_cast<uint32_t>(std::lround(sink_sample_rate));
+        file.seekp(0);
+        file.write("RIFF", 4);
+        put(36 + data_size, 4);
+        file.write("WAVE", 4);
+        file.write("fmt ", 4);
+        put(16, 4);
+        put(1, 2); // PCM
+        put(static_cast<uint32_t>(sink_channel_count), 2);
+        put(rate, 4);
+        put(rate * sink_channel_count * 2, 4);
+        put(static_cast<uint32_t>(sink_channel_count * 2), 2);
+        put(16, 2);
+        file.write("data", 4);
+        put(data_size, 4);
+        file.seekp(0, std::ios::end);
+    }
+
+    // Null Sink
+
+    void NullSink::open(int, double sample_rate) {
+        sink_sample_rate = sample_rate;
+    }
+
+    void NullSink::write(const float*, size_t num_frames) {
+        if (!run_start) {
+            run_start = std::chrono::steady_clock::now();
+            num_run_frames = 0;
+        }
+        num_frames_written += num_frames;
+        num_run_frames += num_frames;
+        ++num_blocks_written;
+    }
+
+    void NullSink::flush() {
+        if (!run_start) return;
+        elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - run_start.value()).count();
+        run_start.reset();
+    }
+
+    double NullSink::realtime_factor() const {
+        if (elapsed_seconds <= 0.0) return 0.0;
+        return static_cast<double>(num_run_frames) / sink_sample_rate / elapsed_seconds;
+    }
+
+} // namespace Cyn
@@ -56,39 +56,31 @@ Eigen::ArrayX<WaveT> samples_audio(WaveT duration, bool filter_high_freqs = true
 }
 
 
+// The shared player for SAMPLE_RATE, created the first time it is requested.
+// Rates the output device does not support are resampled to its default rate while playing, so any SAMPLE_RATE plays.
 inline static Player& player() {
-    if (isclose(SAMPLE_RATE, 44100.0f, TOLERANCE)) {
-        return player_44100;
-    }
-    else if (isclose(SAMPLE_RATE, 44800.0f, TOLERANCE)) {
-        return player_44800;
-    }
-    else {
-        throw std::runtime_error("No player found for the configured sample rate. Please use 44100 or 44800 [Hz].");
-    }
+    return get_player(static_cast<double>(SAMPLE_RATE));
 }
 
 
 inline void queue_audio(WaveT duration, bool filter_high_freqs = true, bool remove_bias = true, bool scale_samples = true, std::optional<WaveT> tolerance = std::nullopt) const {
     Eigen::ArrayX<WaveT> samples_to_queue = samples_audio(duration, filter_high_freqs, remove_bias, scale_samples, tolerance);
     if constexpr (std::is_same_v<WaveT, float>) {
-        // Directly copy data when WaveT is float
-        std::vector<float> vec_samples_to_queue(samples_to_queue.data(), samples_to_queue.data() + samples_to_queue.size());
-        player().add_samples(vec_samples_to_queue);
+        // The player copies straight from the rendered array when WaveT is float
+        player().add_samples(std::span<const float>(samples_to_queue.data(), static_cast<size_t>(samples_to_queue.size())));
     }
     else {
-        // Convert each sample to float otherwise
+        // Convert each sample to float otherwise, and hand the converted vector over
         std::vector<float> vec_samples_to_queue(samples_to_queue.size());
         std::transform(samples_to_queue.data(), samples_to_queue.data() + samples_to_queue.size(), vec_samples_to_queue.begin(),
             [](WaveT sample) { return static_cast<float>(sample); });
-        player().add_samples(vec_samples_to_queue);
+        player().add_samples(std::move(vec_samples_to_queue));
     }
 }
 
 
 inline static void queue_silence(WaveT duration) {
-    std::vector<float> vec_silence(static_cast<size_t>(SAMPLE_RATE * duration), 0.0f);
-    player().add_samples(vec_silence);
+    player().add_silence(static_cast<double>(duration));
 }
 
 
@@ -5,12 +5,19 @@
  */
 
 #include "CynPlayer.h"
+#include "CynResampler.hpp"
+#include "CynRingBuffer.hpp"
 
-#include "portaudio.h"
-
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
 #include <chrono>
 #include <condition_variable>
+#include <cmath>
+#include <deque>
 #include <iostream>
+#include <map>
 #include <mutex>
 #include <sstream>
 #include <stdexcept>
@@ -22,118 +29,197 @@ namespace Cyn {
         std::this_thread::sleep_for(std::chrono::duration<double>(duration));
     }
 
-    class ScopedPaHandler {
-    public:
-        ScopedPaHandler() : _result(Pa_Initialize()) {}
-        ~ScopedPaHandler() {
-            if (_result == paNoError) {
-                Pa_Terminate();
-            }
-        }
-        PaError result() const { return _result; }
-    private:
-        PaError _result;
-    };
-
+    // Queued samples live in producer side chunks, one per add_samples() call. While playing, a feeder thread moves them into a lock-free
+    // ring buffer, which is all the audio callback ever touches: it takes no locks and never sees a reallocation.
+    // With a backend that is not real-time the callback tops up the ring itself, so offline renders never underrun.
+    // Samples stay at the player's rate, the feeder resamples them on their way into the ring when the backend plays
+    // at another rate. Unless looping, each chunk is released as soon as it is fully in the ring, so memory follows the
+    // audio still waiting to be played rather than everything queued since the player was created. The ring then holds
+    // the only copy of those frames, so it keeps them across stop() and start() resumes with them.
     class Player::Impl {
     public:
-        Impl(const std::vector<float>& left_channel_samples, const std::vector<float>& right_channel_samples, std::optional<double> duration = std::nullopt, double sample_rate = 44100.0, bool do_loop = false);
-        Impl(const std::vector<float>& samples, std::optional<double> duration = std::nullopt, double sample_rate = 44100.0, bool do_loop = false);
+        Impl(const std::vector<float>& left_channel_samples, const std::vector<float>& right_channel_samples, std::optional<double> duration, double sample_rate, bool do_loop, std::unique_ptr<AudioBackend> backend);
+        Impl(const std::vector<float>& samples, std::optional<double> duration, double sample_rate, bool do_loop, std::unique_ptr<AudioBackend> backend);
         ~Impl();
 
         bool start();
         bool stop();
         void wait_for_playback();
         bool play();
-        void add_samples(const std::vector<float>& samples);
-        void add_samples(const std::vector<float>& left_channel_samples, const std::vector<float>& right_channel_samples);
+        void add_samples(std::span<const float> samples);
+        void add_samples(std::vector<float>&& samples);
+        void add_samples(std::span<const float> left_channel_samples, std::span<const float> right_channel_samples);
+        void add_interleaved_samples(std::vector<float>&& frames);
+        void add_silence(double duration);
         void clear_samples();
-
+        void schedule_voice(std::unique_ptr<Voice> voice, double start_time);
+        size_t get_num_underruns() const;
+        size_t get_num_queued_frames();
+        double get_sample_rate() const;
+        double get_output_sample_rate() const;
 
     private:
-        PaStream* stream;
-        std::vector<float> left, right;
+        // Samples from one add call, never modified once queued. Silence stores no samples.
+        struct Chunk {
+            std::vector<float> samples; // Interleaved frames, empty for silence
+            size_t num_frames;
+        };
+
+        struct ScheduledVoice {
+            Voice* voice;
+            size_t start_frame;
+        };
+
+        static constexpr size_t max_active_voices = 256;
+        static constexpr size_t voice_queue_capacity = 1024;
+
+        std::unique_ptr<AudioBackend> backend;
+        bool is_open;
+        std::deque<Chunk> chunks;
         int channel_count;
         double sample_rate;
         bool do_loop;
-        size_t num_samples_to_play, num_samples_played, idx;
-
-        std::mutex playback_mutex, samples_mutex;
+        size_t num_frames_queued, num_frames_to_play, num_frames_fed;
+        size_t feed_chunk, feed_offset, feed_frame; // Next frame to feed: its chunk, offset within that chunk and frame in the queue
+
+        std::atomic<double> output_rate;
+        std::unique_ptr<RingBuffer<float>> ring; // Sized for output_rate when the backend is opened
+        std::optional<Resampler> resampler;
+        std::vector<float> resampled; // Resampler output on its way into the ring
+        std::atomic<bool> feed_done; // Every frame to play has been written to the ring
+        std::atomic<size_t> num_underruns;
+        std::atomic<size_t> num_frames_played;
+
+        // Voices wait in pending_voices (sorted by start time) until they are due within one ring's worth of frames,
+        // then the feeder hands them to the callback through voice_queue. The callback renders them from active_voices
+        // and hands finished ones back through retired_voices, so they are deleted off the real-time thread.
+        std::multimap<double, std::unique_ptr<Voice>> pending_voices;
+        RingBuffer<ScheduledVoice> voice_queue;
+        RingBuffer<Voice*> retired_voices;
+        std::vector<ScheduledVoice> active_voices;
+        std::atomic<size_t> num_voices; // Scheduled and not yet retired
+        std::mutex voice_mutex;
+
+        std::thread feeder;
+        bool feeder_running;
+        std::condition_variable feed_condition, space_condition;
+
+        std::mutex control_mutex, playback_mutex, samples_mutex;
         std::condition_variable playback_condition;
-        bool playback_finished;
-
-        void set_playback_finished(bool is_finished, bool acquire_lock = true);
-        bool open(std::optional<int> device_index = std::nullopt);
-        bool close();
-        void paEnsureInit();
-
-        int paCallbackMethod(const void* inputBuffer, void* outputBuffer, unsigned long framesPerBuffer, const PaStreamCallbackTimeInfo* timeInfo, PaStreamCallbackFlags statusFlags);
-        static int paCallback(const void* inputBuffer, void* outputBuffer, unsigned long framesPerBuffer, const PaStreamCallbackTimeInfo* timeInfo, PaStreamCallbackFlags statusFlags, void* userData);
-        void paStreamFinishedMethod();
-        static void paStreamFinished(void* userData);
-
-        static ScopedPaHandler paHandler;
+        bool playback_finished, stream_running;
+
+        void set_playback_finished(bool is_finished);
+        void finish_playback();
+        bool open();
+        void close();
+
+        size_t pending_frames() const;
+        void append_chunk(Chunk chunk, std::unique_lock<std::mutex>& lock);
+        void feed_ring();
+        void write_ring(const float* frames, size_t num_frames);
+        void write_silence(size_t num_frames);
+        bool flush_resampler();
+        void feed_loop();
+        void stop_feeder();
+        void feed_voices();
+        void delete_retired_voices();
+        void clear_voices();
+        void mix_voices(float* out, size_t num_frames);
+
+        bool render(float* out, size_t num_frames);
     };
 
-    ScopedPaHandler Player::Impl::paHandler;
+    // Roughly a quarter second of frames, rounded up to a power of two
+    static size_t ring_capacity(double sample_rate, int channel_count) {
+        return std::bit_ceil(static_cast<size_t>(sample_rate / 4.0)) * static_cast<size_t>(channel_count);
+    }
 
-    Player::Impl::Impl(const std::vector<float>& left_channel_samples, const std::vector<float>& right_channel_samples, std::optional<double> duration, double sample_rate, bool do_loop)
-        : left(left_channel_samples), right(right_channel_samples), channel_count(2), sample_rate(sample_rate), do_loop(do_loop), stream(nullptr) {
-        paEnsureInit();
-        if (left.size() != right.size()) {
+    Player::Impl::Impl(const std::vector<float>& left_channel_samples, const std::vector<float>& right_channel_samples, std::optional<double> duration, double sample_rate, bool do_loop, std::unique_ptr<AudioBackend> backend)
+        : backend(std::move(backend)), is_open(false), channel_count(2), sample_rate(sample_rate), do_loop(do_loop),
+        num_frames_queued(left_channel_samples.size()), num_frames_fed(0), feed_chunk(0), feed_offset(0), feed_frame(0),
+        output_rate(sample_rate), feed_done(false), num_underruns(0), num_frames_played(0),
+        voice_queue(voice_queue_capacity), retired_voices(voice_queue_capacity + max_active_voices), num_voices(0), feeder_running(false), playback_finished(true), stream_running(false) {
+        active_voices.reserve(max_active_voices);
+        if (left_channel_samples.size() != right_channel_samples.size()) {
             throw std::length_error("Left and right channel sizes must match.");
         }
-        num_samples_to_play = duration ? static_cast<size_t>(this->sample_rate * duration.value()) : left.size();
-        if (num_samples_to_play > left.size() && !do_loop) {
-            throw std::invalid_argument("Duration exceeds available samples, and looping is disabled.");
+        if (!left_channel_samples.empty()) {
+            std::vector<float> frames(2 * left_channel_samples.size());
+            for (size_t i = 0; i < left_channel_samples.size(); ++i) {
+                frames[2 * i] = left_channel_samples[i];
+                frames[2 * i + 1] = right_channel_samples[i];
+            }
+            chunks.push_back({ std::move(frames), left_channel_samples.size() });
         }
-        set_playback_finished(true);
-        if (!open()) {
-            throw std::runtime_error("Failed to open audio stream.");
+        num_frames_to_play = duration ? static_cast<size_t>(this->sample_rate * duration.value()) : left_channel_samples.size();
+        if (num_frames_to_play > left_channel_samples.size() && !do_loop) {
+            throw std::invalid_argument("Duration exceeds available samples, and looping is disabled.");
         }
     }
 
-    Player::Impl::Impl(const std::vector<float>& samples, std::optional<double> duration, double sample_rate, bool do_loop)
-        : left(samples), channel_count(1), sample_rate(sample_rate), do_loop(do_loop), stream(nullptr) {
-        paEnsureInit();
-        num_samples_to_play = duration ? static_cast<size_t>(this->sample_rate * duration.value()) : left.size();
-        if (num_samples_to_play > left.size() && !do_loop) {
-            throw std::invalid_argument("Duration exceeds available samples, and looping is disabled.");
+    Player::Impl::Impl(const std::vector<float>& samples, std::optional<double> duration, double sample_rate, bool do_loop, std::unique_ptr<AudioBackend> backend)
+        : backend(std::move(backend)), is_open(false), channel_count(1), sample_rate(sample_rate), do_loop(do_loop),
+        num_frames_queued(samples.size()), num_frames_fed(0), feed_chunk(0), feed_offset(0), feed_frame(0),
+        output_rate(sample_rate), feed_done(false), num_underruns(0), num_frames_played(0),
+        voice_queue(voice_queue_capacity), retired_voices(voice_queue_capacity + max_active_voices), num_voices(0), feeder_running(false), playback_finished(true), stream_running(false) {
+        active_voices.reserve(max_active_voices);
+        if (!samples.empty()) {
+            chunks.push_back({ samples, samples.size() });
         }
-        set_playback_finished(true);
-        if (!open()) {
-            throw std::runtime_error("Failed to open audio stream.");
+        num_frames_to_play = duration ? static_cast<size_t>(this->sample_rate * duration.value()) : samples.size();
+        if (num_frames_to_play > samples.size() && !do_loop) {
+            throw std::invalid_argument("Duration exceeds available samples, and looping is disabled.");
         }
     }
 
     Player::Impl::~Impl() {
-        if (!close()) {
-            std::cerr << "Error: Failed to close the stream during destruction." << std::endl;
-        }
+        stop();
+        clear_voices();
+        close();
     }
 
     bool Player::Impl::start() {
-        std::lock_guard<std::mutex> lock(playback_mutex);
-        if (!stream || !playback_finished) return false;
+        std::lock_guard<std::mutex> control_lock(control_mutex);
+        if (stream_running || (!is_open && !open())) return false;
+
+        {
+            std::lock_guard<std::mutex> lock(samples_mutex);
+            // A looping player starts over from its first chunk, otherwise feeding continues after the frames still in the ring
+            if (do_loop) {
+                ring->clear();
+                if (resampler) resampler->reset();
+                feed_chunk = feed_offset = feed_frame = num_frames_fed = 0;
+            }
+            feed_done.store(false);
+            num_underruns.store(0);
+            num_frames_played.store(0);
+            feed_ring();
+            feed_voices();
+            feeder_running = true;
+        }
+        feeder = std::thread(&Impl::feed_loop, this);
+        set_playback_finished(false);
 
-        PaError err = Pa_StartStream(stream);
-        if (err == paNoError) {
-            set_playback_finished(false, false);
+        if (backend->start()) {
+            stream_running = true;
             return true;
         }
+        stop_feeder();
+        set_playback_finished(true);
         return false;
     }
 
     bool Player::Impl::stop() {
-        std::lock_guard<std::mutex> lock(playback_mutex);
-        if (!stream || playback_finished) return false;
-
-        PaError err = Pa_StopStream(stream);
-        if (err == paNoError) {
-            set_playback_finished(true, false);
-            return true;
-        }
-        return false;
+        std::lock_guard<std::mutex> control_lock(control_mutex);
+        if (!is_open || !stream_running) return false;
+
+        // Not under playback_mutex, the backend may report the end of playback from inside stop()
+        bool is_stopped = backend->stop();
+        stream_running = false;
+        stop_feeder();
+        clear_voices();
+        set_playback_finished(true);
+        return is_stopped;
     }
 
     void Player::Impl::wait_for_playback() {
@@ -147,142 +233,347 @@ namespace Cyn {
         return stop();
     }
 
-    void Player::Impl::add_samples(const std::vector<float>& samples) {
-        std::lock_guard<std::mutex> lock(samples_mutex);
+    void Player::Impl::add_samples(std::span<const float> samples) {
+        add_samples(std::vector<float>(samples.begin(), samples.end()));
+    }
+
+    void Player::Impl::add_samples(std::vector<float>&& samples) {
         if (channel_count != 1) {
             throw std::runtime_error("Mono output configured; input only one sample vector.");
         }
-        num_samples_to_play += samples.size();
-        left.insert(left.end(), samples.begin(), samples.end());
+        size_t num_frames = samples.size();
+        std::unique_lock<std::mutex> lock(samples_mutex);
+        append_chunk({ std::move(samples), num_frames }, lock);
     }
 
-    void Player::Impl::add_samples(const std::vector<float>& left_channel_samples, const std::vector<float>& right_channel_samples) {
+    void Player::Impl::add_samples(std::span<const float> left_channel_samples, std::span<const float> right_channel_samples) {
         if (left_channel_samples.size() != right_channel_samples.size()) {
             throw std::length_error("Left and right channel sizes must match.");
         }
-        std::lock_guard<std::mutex> lock(samples_mutex);
         if (channel_count != 2) {
             throw std::runtime_error("Stereo output configured; input two sample vectors.");
         }
-        num_samples_to_play += left_channel_samples.size();
-        left.insert(left.end(), left_channel_samples.begin(), left_channel_samples.end());
-        right.insert(right.end(), right_channel_samples.begin(), right_channel_samples.end());
+        std::vector<float> frames(2 * left_channel_samples.size());
+        for (size_t i = 0; i < left_channel_samples.size(); ++i) {
+            frames[2 * i] = left_channel_samples[i];
+            frames[2 * i + 1] = right_channel_samples[i];
+        }
+        std::unique_lock<std::mutex> lock(samples_mutex);
+        append_chunk({ std::move(frames), left_channel_samples.size() }, lock);
+    }
+
+    void Player::Impl::add_interleaved_samples(std::vector<float>&& frames) {
+        if (frames.size() % channel_count != 0) {
+            throw std::length_error("Interleaved samples must hold a whole number of frames.");
+        }
+        size_t num_frames = frames.size() / channel_count;
+        std::unique_lock<std::mutex> lock(samples_mutex);
+        append_chunk({ std::move(frames), num_frames }, lock);
+    }
+
+    void Player::Impl::add_silence(double duration) {
+        size_t num_frames = static_cast<size_t>(sample_rate * std::max(duration, 0.0));
+        std::unique_lock<std::mutex> lock(samples_mutex);
+        append_chunk({ {}, num_frames }, lock);
     }
 
     void Player::Impl::clear_samples() {
         stop();
         std::lock_guard<std::mutex> lock(samples_mutex);
-        left.clear();
-        right.clear();
+        chunks.clear();
+        num_frames_queued = num_frames_to_play = num_frames_fed = 0;
+        feed_chunk = feed_offset = feed_frame = 0;
+        if (ring) ring->clear();
+        if (resampler) resampler->reset();
     }
 
-    void Player::Impl::set_playback_finished(bool is_finished, bool acquire_lock) {
-        if (acquire_lock) {
-            std::lock_guard<std::mutex> lock(playback_mutex);
+    void Player::Impl::schedule_voice(std::unique_ptr<Voice> voice, double start_time) {
+        if (!voice) {
+            throw std::invalid_argument("Cannot schedule a null voice.");
         }
+        std::lock_guard<std::mutex> lock(voice_mutex);
+        num_voices.fetch_add(1);
+        pending_voices.emplace(std::max(start_time, 0.0), std::move(voice));
+    }
+
+    size_t Player::Impl::get_num_underruns() const {
+        return num_underruns.load(std::memory_order_relaxed);
+    }
+
+    size_t Player::Impl::get_num_queued_frames() {
+        std::lock_guard<std::mutex> lock(samples_mutex);
+        return num_frames_queued;
+    }
+
+    double Player::Impl::get_sample_rate() const {
+        return sample_rate;
+    }
+
+    double Player::Impl::get_output_sample_rate() const {
+        return output_rate.load();
+    }
+
+    void Player::Impl::set_playback_finished(bool is_finished) {
+        std::lock_guard<std::mutex> lock(playback_mutex);
         playback_finished = is_finished;
-        if (is_finished) {
-            idx = num_samples_played = 0;
-        }
-        playback_condition.notify_one();
+        playback_condition.notify_all();
     }
 
-    bool Player::Impl::open(std::optional<int> device_index) {
-        PaDeviceIndex index = device_index.value_or(Pa_GetDefaultOutputDevice());
+    // Backend thread, once the stream has ended on its own or been stopped. Nothing drains the ring anymore, so the
+    // feeder is released and producers waiting in append_chunk for space stop waiting.
+    void Player::Impl::finish_playback() {
+        {
+            std::lock_guard<std::mutex> lock(samples_mutex);
+            feeder_running = false;
+        }
+        feed_condition.notify_all();
+        space_condition.notify_all();
+        set_playback_finished(true);
+    }
 
-        PaStreamParameters outputParameters = {};
-        outputParameters.device = index;
-        if (outputParameters.device == paNoDevice) return false;
+    size_t Player::Impl::pending_frames() const {
+        return num_frames_queued - feed_frame;
+    }
 
-        outputParameters.channelCount = channel_count;
-        outputParameters.sampleFormat = paFloat32;
-        outputParameters.suggestedLatency = Pa_GetDeviceInfo(outputParameters.device)->defaultLowOutputLatency;
+    // Expects samples_mutex held through lock. While playing, blocks until the frames not yet fed to the ring fit in
+    // one ring's worth, so a producer running ahead of playback is held back instead of growing the backlog without bound.
+    void Player::Impl::append_chunk(Chunk chunk, std::unique_lock<std::mutex>& lock) {
+        if (chunk.num_frames == 0) return;
+        if (!do_loop) {
+            space_condition.wait(lock, [&]() { return !feeder_running || pending_frames() * channel_count <= ring->capacity(); });
+        }
+        num_frames_queued += chunk.num_frames;
+        num_frames_to_play += chunk.num_frames;
+        chunks.push_back(std::move(chunk));
+        feed_done.store(false);
+        feed_condition.notify_one();
+    }
 
-        PaError err = Pa_OpenStream(
-            &stream,
-            nullptr,
-            &outputParameters,
-            sample_rate,
-            paFramesPerBufferUnspecified,
-            paNoFlag,
-            &Impl::paCallback,
-            this
-        );
+    // Expects samples_mutex held
+    void Player::Impl::feed_ring() {
+        while (num_frames_fed < num_frames_to_play) {
+            size_t space_frames = ring->space() / channel_count;
+            if (resampler) space_frames = resampler->input_frames(space_frames);
+            if (space_frames == 0) break;
+            if (feed_chunk >= chunks.size()) {
+                if (do_loop && num_frames_queued > 0) {
+                    feed_chunk = feed_offset = feed_frame = 0;
+                    continue;
+                }
+                break;
+            }
+            const Chunk& chunk = chunks[feed_chunk];
+            size_t frames_to_feed = std::min({ space_frames, chunk.num_frames - feed_offset, num_frames_to_play - num_frames_fed });
+            if (chunk.samples.empty()) {
+                write_silence(frames_to_feed);
+            }
+            else {
+                write_ring(chunk.samples.data() + feed_offset * channel_count, frames_to_feed);
+            }
+            feed_offset += frames_to_feed;
+            feed_frame += frames_to_feed;
+            num_frames_fed += frames_to_feed;
+            if (feed_offset < chunk.num_frames) continue;
+            feed_offset = 0;
+            if (do_loop) {
+                ++feed_chunk;
+                continue;
+            }
+            // Never needed again once in the ring. The counters drop by the same amount, so a later start()
+            // continues with what is left after the ring's frames.
+            num_frames_queued -= chunk.num_frames;
+            num_frames_to_play -= chunk.num_frames;
+            num_frames_fed -= chunk.num_frames;
+            feed_frame -= chunk.num_frames;
+            chunks.pop_front();
+        }
+        if (num_frames_fed >= num_frames_to_play && flush_resampler()) {
+            feed_done.store(true, std::memory_order_release);
+        }
+    }
 
-        if (err == paNoError) {
-            err = Pa_SetStreamFinishedCallback(stream, &Impl::paStreamFinished);
+    // Expects samples_mutex held and room in the ring for the output
+    void Player::Impl::write_ring(const float* frames, size_t num_frames) {
+        if (!resampler) {
+            ring->write(frames, num_frames * channel_count);
+            return;
         }
+        resampled.clear();
+        resampler->process(frames, num_frames, resampled);
+        ring->write(resampled.data(), resampled.size());
+    }
 
-        if (err != paNoError) {
-            Pa_CloseStream(stream);
-            stream = nullptr;
-            return false;
+    // Expects samples_mutex held and room in the ring for the output
+    void Player::Impl::write_silence(size_t num_frames) {
+        static const std::array<float, 4096> zeros{};
+        size_t block_frames = zeros.size() / channel_count;
+        while (num_frames > 0) {
+            size_t frames_to_write = std::min(num_frames, block_frames);
+            write_ring(zeros.data(), frames_to_write);
+            num_frames -= frames_to_write;
         }
+    }
 
+    // Expects samples_mutex held. The resampler holds back its last few output frames until the input that follows them
+    // arrives, so samples added while playing join seamlessly. Once the ring runs low with nothing more queued they are
+    // flushed as if followed by silence. Returns true once nothing is held back.
+    bool Player::Impl::flush_resampler() {
+        if (!resampler || resampler->flush_frames() == 0) return true;
+        if (ring->size() > ring->capacity() / 2 || ring->space() < resampler->flush_frames() * channel_count) return false;
+        resampled.clear();
+        resampler->flush(resampled);
+        ring->write(resampled.data(), resampled.size());
         return true;
     }
 
-    bool Player::Impl::close() {
-        if (!stream) return false;
+    void Player::Impl::feed_loop() {
+        // Top up whenever about a quarter of the ring has been played, or sooner when samples are added
+        auto refill_interval = std::chrono::duration<double>(static_cast<double>(ring->capacity() / channel_count) / (4.0 * output_rate.load()));
+        std::unique_lock<std::mutex> lock(samples_mutex);
+        while (feeder_running) {
+            feed_ring();
+            space_condition.notify_all();
+            feed_voices();
+            feed_condition.wait_for(lock, refill_interval);
+        }
+    }
 
-        PaError err = Pa_CloseStream(stream);
-        stream = nullptr;
-        return (err == paNoError);
+    void Player::Impl::stop_feeder() {
+        {
+            std::lock_guard<std::mutex> lock(samples_mutex);
+            feeder_running = false;
+        }
+        feed_condition.notify_all();
+        space_condition.notify_all();
+        if (feeder.joinable()) {
+            feeder.join();
+        }
     }
 
-    void Player::Impl::paEnsureInit() {
-        if (paHandler.result() != paNoError) {
-            throw std::runtime_error("Failed to initialize PortAudio: " + std::string(Pa_GetErrorText(paHandler.result())));
+    // Hands pending voices that are due within one ring's worth of frames to the callback
+    void Player::Impl::feed_voices() {
+        std::lock_guard<std::mutex> lock(voice_mutex);
+        delete_retired_voices();
+        double rate = output_rate.load();
+        size_t horizon = num_frames_played.load(std::memory_order_relaxed) + ring->capacity() / channel_count;
+        while (!pending_voices.empty()) {
+            size_t start_frame = static_cast<size_t>(std::llround(pending_voices.begin()->first * rate));
+            if (start_frame > horizon || voice_queue.space() == 0) break;
+            ScheduledVoice scheduled{ pending_voices.begin()->second.get(), start_frame };
+            scheduled.voice->set_sample_rate(rate);
+            voice_queue.write(&scheduled, 1);
+            pending_voices.begin()->second.release();
+            pending_voices.erase(pending_voices.begin());
         }
     }
 
-    int Player::Impl::paCallbackMethod(const void* inputBuffer, void* outputBuffer,
-        unsigned long framesPerBuffer,
-        const PaStreamCallbackTimeInfo*, PaStreamCallbackFlags) {
-        std::lock_guard<std::mutex> lock(samples_mutex);
-        float* out = static_cast<float*>(outputBuffer);
-
-        for (size_t i = 0; i < framesPerBuffer; ++i) {
-            *out++ = left[idx];
-            if (channel_count == 2) *out++ = right[idx];
-            idx++;
-            num_samples_played++;
-            if (num_samples_played >= num_samples_to_play) {
-                set_playback_finished(true);
-                return paComplete;
+    // Expects voice_mutex held
+    void Player::Impl::delete_retired_voices() {
+        Voice* voice;
+        while (retired_voices.read(&voice, 1) == 1) {
+            delete voice;
+        }
+    }
+
+    // Only while the stream is stopped, the callback owns active_voices and reads voice_queue otherwise
+    void Player::Impl::clear_voices() {
+        std::lock_guard<std::mutex> lock(voice_mutex);
+        delete_retired_voices();
+        for (ScheduledVoice& scheduled : active_voices) {
+            delete scheduled.voice;
+        }
+        active_voices.clear();
+        ScheduledVoice scheduled;
+        while (voice_queue.read(&scheduled, 1) == 1) {
+            delete scheduled.voice;
+        }
+        pending_voices.clear();
+        num_voices.store(0);
+    }
+
+    // Real-time thread: adds every due voice into out, starting each at its own frame within the buffer
+    void Player::Impl::mix_voices(float* out, size_t num_frames) {
+        ScheduledVoice scheduled;
+        while (active_voices.size() < max_active_voices && voice_queue.read(&scheduled, 1) == 1) {
+            active_voices.push_back(scheduled);
+        }
+        size_t buffer_start = num_frames_played.load(std::memory_order_relaxed);
+        size_t buffer_end = buffer_start + num_frames;
+        for (size_t i = 0; i < active_voices.size();) {
+            ScheduledVoice& active = active_voices[i];
+            if (active.start_frame >= buffer_end) {
+                ++i;
+                continue;
             }
-            if (idx >= left.size()) {
-                if (do_loop) {
-                    idx -= left.size();
-                }
-                else {
-                    std::fill(out, out + (framesPerBuffer - i) * channel_count, 0.0f);
-                    set_playback_finished(true);
-                    return paComplete;
-                }
+            size_t offset = active.start_frame > buffer_start ? active.start_frame - buffer_start : 0;
+            bool is_playing = active.voice->render(out + offset * channel_count, num_frames - offset, channel_count);
+            if (!is_playing && retired_voices.write(&active.voice, 1) == 1) {
+                num_voices.fetch_sub(1, std::memory_order_release);
+                active = active_voices.back();
+                active_voices.pop_back();
+                continue;
             }
+            ++i;
         }
-        return paContinue;
     }
 
-    int Player::Impl::paCallback(const void* inputBuffer, void* outputBuffer,
-        unsigned long framesPerBuffer,
-        const PaStreamCallbackTimeInfo* timeInfo,
-        PaStreamCallbackFlags statusFlags, void* userData) {
-        return static_cast<Impl*>(userData)->paCallbackMethod(inputBuffer, outputBuffer, framesPerBuffer, timeInfo, statusFlags);
+    // Expects control_mutex held. The default backend is created here, so PortAudio is only initialized once a player starts.
+    bool Player::Impl::open() {
+        if (!backend) {
+            backend = portaudio_backend();
+        }
+        double rate = backend->supported_sample_rate(channel_count, sample_rate);
+        if (!(rate > 0)) return false;
+        // The feeder is not running yet, so nothing else touches the ring or the resampler
+        ring = std::make_unique<RingBuffer<float>>(ring_capacity(rate, channel_count));
+        if (std::llround(rate) != std::llround(sample_rate)) {
+            resampler.emplace(sample_rate, rate, channel_count);
+        }
+        else {
+            resampler.reset();
+        }
+        output_rate.store(rate);
+        is_open = backend->open(channel_count, rate,
+            [this](float* out, size_t num_frames) { return render(out, num_frames); },
+            [this]() { finish_playback(); });
+        return is_open;
     }
 
-    void Player::Impl::paStreamFinishedMethod() {}
+    void Player::Impl::close() {
+        if (!is_open) return;
+        backend->close();
+        is_open = false;
+    }
 
-    void Player::Impl::paStreamFinished(void* userData) {
-        static_cast<Impl*>(userData)->paStreamFinishedMethod();
+    // Backend thread: on a real-time backend it reads the ring only, no locks, no allocation. Returns false once playback is complete.
+    bool Player::Impl::render(float* out, size_t num_frames) {
+        if (!backend->is_realtime()) {
+            std::lock_guard<std::mutex> lock(samples_mutex);
+            feed_ring();
+            space_condition.notify_all();
+            feed_voices();
+        }
+        size_t num_values = num_frames * channel_count;
+        size_t num_read = ring->read(out, num_values);
+        std::fill(out + num_read, out + num_values, 0.0f);
+        mix_voices(out, num_frames);
+        num_frames_played.fetch_add(num_frames, std::memory_order_relaxed);
+        if (num_read < num_values) {
+            if (!feed_done.load(std::memory_order_acquire) || !ring->empty()) {
+                num_underruns.fetch_add(1, std::memory_order_relaxed);
+            }
+            else if (num_voices.load(std::memory_order_acquire) == 0) {
+                return false;
+            }
+        }
+        return true;
     }
 
-    Player::Player(const std::vector<float>& left_channel_samples, const std::vector<float>& right_channel_samples, std::optional<double> duration, double sample_rate, bool do_loop)
-        : pImpl(std::make_unique<Impl>(left_channel_samples, right_channel_samples, duration, sample_rate, do_loop)) {}
+    Player::Player(const std::vector<float>& left_channel_samples, const std::vector<float>& right_channel_samples, std::optional<double> duration, double sample_rate, bool do_loop, std::unique_ptr<AudioBackend> backend)
+        : pImpl(std::make_unique<Impl>(left_channel_samples, right_channel_samples, duration, sample_rate, do_loop, std::move(backend))) {}
 
-    Player::Player(const std::vector<float>& samples, std::optional<double> duration, double sample_rate, bool do_loop)
-        : pImpl(std::make_unique<Impl>(samples, duration, sample_rate, do_loop)) {}
+    Player::Player(const std::vector<float>& samples, std::optional<double> duration, double sample_rate, bool do_loop, std::unique_ptr<AudioBackend> backend)
+        : pImpl(std::make_unique<Impl>(samples, duration, sample_rate, do_loop, std::move(backend))) {}
 
     Player::~Player() = default;
 
@@ -292,15 +583,47 @@ namespace Cyn {
     bool Player::play() { return pImpl->play(); }
 
     void Player::add_samples(const std::vector<float>& samples) {
+        pImpl->add_samples(std::span<const float>(samples));
+    }
+    void Player::add_samples(std::vector<float>&& samples) {
+        pImpl->add_samples(std::move(samples));
+    }
+    void Player::add_samples(std::span<const float> samples) {
         pImpl->add_samples(samples);
     }
     void Player::add_samples(const std::vector<float>& left_channel_samples, const std::vector<float>& right_channel_samples) {
+        pImpl->add_samples(std::span<const float>(left_channel_samples), std::span<const float>(right_channel_samples));
+    }
+    void Player::add_samples(std::span<const float> left_channel_samples, std::span<const float> right_channel_samples) {
         pImpl->add_samples(left_channel_samples, right_channel_samples);
     }
+    void Player::add_interleaved_samples(std::vector<float>&& frames) {
+        pImpl->add_interleaved_samples(std::move(frames));
+    }
+    void Player::add_silence(double duration) {
+        pImpl->add_silence(duration);
+    }
 
     void Player::clear_samples() { pImpl->clear_samples(); }
+    void Player::schedule_voice(std::unique_ptr<Voice> voice, double start_time) { pImpl->schedule_voice(std::move(voice), start_time); }
+    size_t Player::num_underruns() const { return pImpl->get_num_underruns(); }
+    size_t Player::num_queued_frames() const { return pImpl->get_num_queued_frames(); }
+    double Player::sample_rate() const { return pImpl->get_sample_rate(); }
+    double Player::output_sample_rate() const { return pImpl->get_output_sample_rate(); }
+
+    Player& get_player(double sample_rate) {
+        static std::mutex registry_mutex;
+        static std::map<long long, std::unique_ptr<Player>> players; // Keyed by the rate rounded to whole Hz
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        long long rate = std::llround(sample_rate);
+        std::unique_ptr<Player>& player = players[rate];
+        if (!player) {
+            player = std::make_unique<Player>(std::vector<float>{}, std::nullopt, static_cast<double>(rate), false);
+        }
+        return *player;
+    }
 
-    Player player_44100(std::vector<float>{}, std::nullopt, 44100.0, false);
-    Player player_44800(std::vector<float>{}, std::nullopt, 44800.0, false);
+    Player& player_44100 = get_player(44100.0);
+    Player& player_44800 = get_player(48000.0);
 
 } // namespace Cyn
@@ -0,0 +1,180 @@
+/*
+ * Except where otherwise noted, Cynthasine  2024 by https://github.com/h2see is licensed under Creative
+ * Commons Attribution-NonCommercial-ShareAlike 4.0 International. To view a
+ * copy of this license, visit https://creativecommons.org/licenses/by-nc-sa/4.0/
+ */
+
+#ifndef CYN_RESAMPLER_HPP
+#define CYN_RESAMPLER_HPP
+
+#include "CynEigen.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+namespace Cyn {
+
+    // Streaming polyphase windowed-sinc resampler for interleaved float frames.
+    // The rate ratio is reduced to up / down over whole Hz with gcd, and output frame k sits exactly at input position
+    // k * down / up, so resampling adds no delay. Each output sample is one Eigen dot product of the Kaiser windowed
+    // sinc phase for its fractional position with the surrounding input frames. When up exceeds max_phases the
+    // fractional position is rounded to the nearest of max_phases phases.
+    class Resampler {
+    public:
+        static constexpr int64_t max_phases = 1024;
+
+        // half_taps input frames on either side of each output frame at unity ratio, widened when downsampling.
+        // passband is the cutoff as a fraction of the lower of the two Nyquist frequencies.
+        Resampler(double input_rate, double output_rate, int channel_count, size_t half_taps = 16, double kaiser_beta = 8.0, double passband = 0.95)
+            : rate_in(input_rate), rate_out(output_rate), num_channels(channel_count) {
+            int64_t rate_in_hz = std::llround(input_rate);
+            int64_t rate_out_hz = std::llround(output_rate);
+            if (rate_in_hz <= 0 || rate_out_hz <= 0) {
+                throw std::invalid_argument("Sample rates must be positive.");
+            }
+            if (channel_count <= 0) {
+                throw std::invalid_argument("Channel count must be positive.");
+            }
+            int64_t divisor = std::gcd(rate_in_hz, rate_out_hz);
+            up = rate_out_hz / divisor;
+            down = rate_in_hz / divisor;
+
+            double ratio = std::min(1.0, static_cast<double>(up) / static_cast<double>(down));
+            double cutoff = passband * ratio;
+            half = static_cast<int64_t>(std::ceil(static_cast<double>(std::max<size_t>(half_taps, 1)) / ratio));
+            num_taps = 2 * half;
+            num_phases = std::min(up, max_phases);
+
+            // Column p holds the taps for fractional position p / num_phases, the extra last column is a whole frame late
+            phases.resize(num_taps, num_phases + 1);
+            double window_norm = std::cyl_bessel_i(0.0, kaiser_beta);
+            for (int64_t p = 0; p <= num_phases; ++p) {
+                double frac = static_cast<double>(p) / static_cast<double>(num_phases);
+                for (int64_t t = 0; t < num_taps; ++t) {
+                    double x = static_cast<double>(t - half + 1) - frac;
+                    double r = x / static_cast<double>(half);
+                    double window = std::abs(r) < 1.0 ? std::cyl_bessel_i(0.0, kaiser_beta * std::sqrt(1.0 - r * r)) / window_norm : 0.0;
+                    double sinc = x == 0.0 ? 1.0 : std::sin(pi<double>() * cutoff * x) / (pi<double>() * cutoff * x);
+                    phases(t, p) = static_cast<float>(cutoff * sinc * window);
+                }
+                // Unity gain at DC for every phase
+                phases.col(p) /= phases.col(p).sum();
+            }
+            history.resize(num_channels);
+            reset();
+        }
+
+        double input_rate() const { return rate_in; }
+        double output_rate() const { return rate_out; }
+        int channel_count() const { return num_channels; }
+
+        // Starts a new stream, as if no input had been seen
+        void reset() {
+            for (std::vector<float>& channel : history) {
+                channel.assign(static_cast<size_t>(half), 0.0f);
+            }
+            history_start = -half;
+            num_input = 0;
+            num_output = 0;
+        }
+
+        // Output frames process() appends for num_input_frames more input frames
+        size_t output_frames(size_t num_input_frames) const {
+            int64_t ready = num_ready(num_input + static_cast<int64_t>(num_input_frames));
+            return static_cast<size_t>(std::max<int64_t>(ready - num_output, 0));
+        }
+
+        // Most input frames whose output fits in num_output_frames
+        size_t input_frames(size_t num_output_frames) const {
+            int64_t limit = (num_output + static_cast<int64_t>(num_output_frames)) * down / up + half - num_input;
+            return static_cast<size_t>(std::max<int64_t>(limit, 0));
+        }
+
+        // Output frames flush() appends
+        size_t flush_frames() const {
+            int64_t total = (num_input * up + down - 1) / down;
+            return static_cast<size_t>(std::max<int64_t>(total - num_output, 0));
+        }
+
+        // Appends the output of num_input_frames interleaved input frames to out. The last few output frames wait
+        // for the input that follows them, see flush().
+        void process(const float* input, size_t num_input_frames, std::vector<float>& out) {
+            for (int c = 0; c < num_channels; ++c) {
+                std::vector<float>& channel = history[c];
+                size_t offset = channel.size();
+                channel.resize(offset + num_input_frames);
+                for (size_t i = 0; i < num_input_frames; ++i) {
+                    channel[offset + i] = input[i * num_channels + c];
+                }
+            }
+            num_input += static_cast<int64_t>(num_input_frames);
+            render(num_ready(num_input), out);
+            discard_history();
+        }
+
+        // Appends the output frames still owed for the input so far, treating the input that follows as silence.
+        // Nothing is consumed, so a stream can continue after a flush, only the flushed frames miss the new input.
+        void flush(std::vector<float>& out) {
+            for (std::vector<float>& channel : history) {
+                channel.resize(channel.size() + static_cast<size_t>(half), 0.0f);
+            }
+            render(num_output + static_cast<int64_t>(flush_frames()), out);
+            for (std::vector<float>& channel : history) {
+                channel.resize(channel.size() - static_cast<size_t>(half));
+            }
+            discard_history();
+        }
+
+    private:
+        // Output frames whose taps all lie within the first total_input input frames
+        int64_t num_ready(int64_t total_input) const {
+            if (total_input <= half) return 0;
+            return ((total_input - half) * up + down - 1) / down;
+        }
+
+        void render(int64_t output_end, std::vector<float>& out) {
+            if (output_end <= num_output) return;
+            size_t offset = out.size();
+            out.resize(offset + static_cast<size_t>(output_end - num_output) * num_channels);
+            float* dst = out.data() + offset;
+            for (int64_t k = num_output; k < output_end; ++k) {
+                int64_t position = k * down;
+                int64_t frame = position / up;
+                int64_t phase = (position % up * num_phases + up / 2) / up;
+                int64_t start = frame - half + 1 - history_start;
+                for (int c = 0; c < num_channels; ++c) {
+                    Eigen::Map<const Eigen::VectorXf> taps(history[c].data() + start, num_taps);
+                    *dst++ = taps.dot(phases.col(phase).matrix());
+                }
+            }
+            num_output = output_end;
+        }
+
+        // Drops the input frames no future output frame reaches
+        void discard_history() {
+            int64_t first_needed = std::min(num_output * down / up - half + 1, num_input - half) - history_start;
+            if (first_needed <= 0) return;
+            for (std::vector<float>& channel : history) {
+                channel.erase(channel.begin(), channel.begin() + first_needed);
+            }
+            history_start += first_needed;
+        }
+
+        double rate_in, rate_out;
+        int num_channels;
+        int64_t up, down; // Output frames per down input frames
+        int64_t half, num_taps, num_phases;
+        Eigen::ArrayXXf phases; // num_taps x (num_phases + 1)
+        std::vector<std::vector<float>> history; // Per channel input, history[c][0] is input frame history_start
+        int64_t history_start;
+        int64_t num_input, num_output;
+    };
+
+} // namespace Cyn
+
+#endif // CYN_RESAMPLER_HPP
\ No newline at end of file
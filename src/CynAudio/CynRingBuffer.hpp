@@ -0,0 +1,85 @@
+/*
+ * Except where otherwise noted, Cynthasine  2024 by https://github.com/h2see is licensed under Creative
+ * Commons Attribution-NonCommercial-ShareAlike 4.0 International. To view a
+ * copy of this license, visit https://creativecommons.org/licenses/by-nc-sa/4.0/
+ */
+
+#ifndef CYN_RING_BUFFER_HPP
+#define CYN_RING_BUFFER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <vector>
+
+namespace Cyn {
+
+    // Bounded lock-free single-producer/single-consumer ring buffer.
+    // One thread may call write() while another calls read(), neither ever blocks or allocates.
+    // clear() is only safe while no thread is reading or writing.
+    template<typename T>
+    class RingBuffer {
+    public:
+        // Capacity is rounded up to a power of two
+        explicit RingBuffer(size_t capacity)
+            : buffer(std::bit_ceil(std::max<size_t>(capacity, 2))), mask(buffer.size() - 1), head(0), tail(0) {}
+
+        RingBuffer(const RingBuffer&) = delete;
+        RingBuffer& operator=(const RingBuffer&) = delete;
+
+        size_t capacity() const { return buffer.size(); }
+
+        // Elements ready to be read, exact on the consumer thread and a lower bound elsewhere
+        size_t size() const {
+            return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+        }
+
+        // Free slots, exact on the producer thread and a lower bound elsewhere
+        size_t space() const {
+            return capacity() - size();
+        }
+
+        bool empty() const { return size() == 0; }
+
+        // Producer side, writes up to count elements and returns how many were written
+        size_t write(const T* data, size_t count) {
+            size_t write_head = head.load(std::memory_order_relaxed);
+            size_t read_tail = tail.load(std::memory_order_acquire);
+            count = std::min(count, capacity() - (write_head - read_tail));
+            size_t first = std::min(count, capacity() - (write_head & mask));
+            std::copy(data, data + first, buffer.begin() + (write_head & mask));
+            std::copy(data + first, data + count, buffer.begin());
+            head.store(write_head + count, std::memory_order_release);
+            return count;
+        }
+
+        // Consumer side, reads up to count elements and returns how many were read
+        size_t read(T* data, size_t count) {
+            size_t read_tail = tail.load(std::memory_order_relaxed);
+            size_t write_head = head.load(std::memory_order_acquire);
+            count = std::min(count, write_head - read_tail);
+            size_t first = std::min(count, capacity() - (read_tail & mask));
+            std::copy(buffer.begin() + (read_tail & mask), buffer.begin() + (read_tail & mask) + first, data);
+            std::copy(buffer.begin(), buffer.begin() + (count - first), data + first);
+            tail.store(read_tail + count, std::memory_order_release);
+            return count;
+        }
+
+        void clear() {
+            head.store(0, std::memory_order_relaxed);
+            tail.store(0, std::memory_order_relaxed);
+        }
+
+    private:
+        static constexpr size_t cache_line = 64;
+        std::vector<T> buffer;
+        size_t mask;
+        // Monotonic counters, the producer owns head and the consumer owns tail
+        alignas(cache_line) std::atomic<size_t> head;
+        alignas(cache_line) std::atomic<size_t> tail;
+    };
+
+} // namespace Cyn
+
+#endif // CYN_RING_BUFFER_HPP
\ No newline at end of file
@@ -0,0 +1,121 @@
+/*
+ * Except where otherwise noted, Cynthasine  2024 by https://github.com/h2see is licensed under Creative
+ * Commons Attribution-NonCommercial-ShareAlike 4.0 International. To view a
+ * copy of this license, visit https://creativecommons.org/licenses/by-nc-sa/4.0/
+ */
+
+#ifndef CYN_WAVE_VOICE_HPP
+#define CYN_WAVE_VOICE_HPP
+
+#include "CynPlayer.h"
+#include "CynWave.h"
+
+#include <algorithm>
+
+namespace Cyn {
+
+    // Renders a WaveArray inside the audio callback with the block phasor recurrence of WaveArray::samples_phasor.
+    // A table holds each wave's amplitude weighted e^(i 2pi f k / sample_rate) for one block, so rendering a block is a
+    // matrix-vector product with the waves' unit phasors, which then advance by one block rotation and are renormalized.
+    // Blocks carry over between callbacks of any size, all state is allocated up front so render() never allocates.
+    template<NumF WaveT>
+    class WaveVoice : public Voice {
+    public:
+        using CalcT = typename WaveArray<WaveT>::CalcT;
+
+        // Waves above the Nyquist frequency are dropped, fade is a raised cosine in and out in seconds
+        WaveVoice(const WaveArray<WaveT>& waves, double sample_rate, std::optional<double> duration = std::nullopt, double fade = 0.0, float gain = 1.0f)
+            : waves(waves), duration(duration), fade(fade), gain(gain) {
+            set_sample_rate(sample_rate);
+        }
+
+        // Rebuilds the table and phasors, only valid before the first render()
+        void set_sample_rate(double sample_rate) override {
+            if (!(sample_rate > 0)) { throw std::invalid_argument("sample_rate must be positive."); }
+            const CalcT two_pi = pi<CalcT>(2.0L);
+            WaveArray<WaveT> audible = waves.filter(waves.freq().abs() <= static_cast<WaveT>(sample_rate / 2));
+            Eigen::Index num_w = audible.num_waves();
+            Eigen::ArrayX<CalcT> cycles = audible.freq().template cast<CalcT>() / static_cast<CalcT>(sample_rate);
+            cycles -= cycles.floor();
+            Eigen::ArrayX<CalcT> steps = Eigen::ArrayX<CalcT>::LinSpaced(block_size, 0, static_cast<CalcT>(block_size - 1));
+            Eigen::ArrayXX<CalcT> table_cycles = (cycles.matrix() * steps.matrix().transpose()).array();
+            table_cycles = (table_cycles - table_cycles.floor()) * two_pi;
+            Eigen::ArrayX<CalcT> amp = audible.amp().template cast<CalcT>();
+            table_re = (table_cycles.cos().colwise() * amp).matrix();
+            table_im = (table_cycles.sin().colwise() * amp).matrix();
+            cycles *= static_cast<CalcT>(block_size);
+            Eigen::ArrayX<CalcT> theta = (cycles - cycles.floor()) * two_pi;
+            rot_re = theta.cos();
+            rot_im = theta.sin();
+            // a * sin(2 pi f t - phase) is the imaginary part of a * e^(-i phase) * e^(i 2 pi f t)
+            z_re = audible.phase().template cast<CalcT>().cos();
+            z_im = -audible.phase().template cast<CalcT>().sin();
+            next_re.resize(num_w);
+            block_result.resize(block_size);
+            block_offset = 0;
+            num_frames = duration.has_value() ? static_cast<size_t>(std::llround(duration.value() * sample_rate)) : std::numeric_limits<size_t>::max();
+            fade_frames = std::min(static_cast<size_t>(std::llround(std::max(fade, 0.0) * sample_rate)), num_frames / 2);
+        }
+
+        bool render(float* output, size_t num_output_frames, int channel_count) override {
+            size_t frames_to_render = std::min(num_output_frames, num_frames - position);
+            for (size_t k = 0; k < frames_to_render;) {
+                Eigen::Index count = static_cast<Eigen::Index>(std::min(static_cast<size_t>(block_size - block_offset), frames_to_render - k));
+                // Im(z e^(i a)) = Re(z) sin(a) + Im(z) cos(a)
+                block_result.head(count).noalias() = table_im.middleCols(block_offset, count).transpose() * z_re.matrix();
+                block_result.head(count).noalias() += table_re.middleCols(block_offset, count).transpose() * z_im.matrix();
+                for (Eigen::Index j = 0; j < count; ++j, ++k) {
+                    float sample = static_cast<float>(block_result(j) * envelope(position + k));
+                    for (int c = 0; c < channel_count; ++c) {
+                        output[k * channel_count + c] += sample;
+                    }
+                }
+                block_offset += count;
+                if (block_offset == block_size) {
+                    advance_block();
+                    block_offset = 0;
+                }
+            }
+            position += frames_to_render;
+            return position < num_frames;
+        }
+
+    private:
+        static constexpr Eigen::Index block_size = 64;
+
+        // Rotates the phasors by one block and renormalizes them so recurrence drift does not build up
+        void advance_block() {
+            next_re = z_re * rot_re - z_im * rot_im;
+            z_im = z_re * rot_im + z_im * rot_re;
+            z_re.swap(next_re);
+            next_re = (z_re.square() + z_im.square()).sqrt();
+            z_re /= next_re;
+            z_im /= next_re;
+        }
+
+        CalcT envelope(size_t frame) const {
+            CalcT result = static_cast<CalcT>(gain);
+            if (fade_frames == 0) { return result; }
+            size_t edge = std::min(frame, num_frames - 1 - frame);
+            if (edge < fade_frames) {
+                result *= static_cast<CalcT>(0.5) - static_cast<CalcT>(0.5) * std::cos(pi<CalcT>() * static_cast<CalcT>(edge) / static_cast<CalcT>(fade_frames));
+            }
+            return result;
+        }
+
+        WaveArray<WaveT> waves;
+        std::optional<double> duration;
+        double fade;
+        Eigen::Matrix<CalcT, Eigen::Dynamic, Eigen::Dynamic> table_re, table_im; // Waves by block samples
+        Eigen::ArrayX<CalcT> z_re, z_im, rot_re, rot_im, next_re;
+        Eigen::Matrix<CalcT, Eigen::Dynamic, 1> block_result;
+        Eigen::Index block_offset = 0;
+        size_t num_frames;
+        size_t fade_frames;
+        size_t position = 0;
+        float gain;
+    };
+
+} // namespace Cyn
+
+#endif // CYN_WAVE_VOICE_HPP
\ No newline at end of file
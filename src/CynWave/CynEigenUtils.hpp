@@ -15,9 +15,14 @@
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <regex>
 #include <sstream>
 #include <string>
+#include <tuple>
+#include <typeindex>
 #include <vector>
 
 namespace pfft = pocketfft;
@@ -26,17 +31,115 @@ namespace Cyn {
 
 	namespace impl {
 
+		// Caches pocketfft plans per (size, transform, precision) so repeated transforms of equal length skip planning,
+		// and transforms into caller owned buffers so steady state loops reuse their storage. Plans are immutable once
+		// built, so one context can be shared across threads; only the plan lookup is locked.
+		class FFTContext {
+		public:
+
+			template<NumF T>
+			std::shared_ptr<const pfft::detail::pocketfft_c<T>> c2c_plan(size_t size) {
+				return this->plan<pfft::detail::pocketfft_c<T>, T>(size, Transform::Complex);
+			}
+
+			template<NumF T>
+			std::shared_ptr<const pfft::detail::pocketfft_r<T>> r2c_plan(size_t size) {
+				return this->plan<pfft::detail::pocketfft_r<T>, T>(size, Transform::Real);
+			}
+
+			// Forward (or with do_inverse, backward and scaled by 1 / size) transform of real input into
+			// the size / 2 + 1 non-negative frequency bins. ArrayX_NumC_out is only reallocated when its size changes.
+			template <typename DerivedIn, typename DerivedOut>
+			void r2c(const Eigen::ArrayBase<DerivedIn>& ArrayX_NumF, const Eigen::ArrayBase<DerivedOut>& ArrayX_NumC_out, bool do_inverse = false) {
+				using T = typename Eigen::ArrayBase<DerivedIn>::Scalar;
+				Eigen::ArrayBase<DerivedOut>& ArrayX_NumC_out_ = const_cast<Eigen::ArrayBase<DerivedOut>&>(ArrayX_NumC_out);
+				size_t size = static_cast<size_t>(ArrayX_NumF.size());
+				ArrayX_NumC_out_.derived().resize(static_cast<Eigen::Index>(size / 2 + 1));
+				if (size == 0) { return; }
+				// Transform in the output buffer: shifted by one real, the halfcomplex result r0 r1 i1 r2 i2 ... lines up
+				// with the complex bins once r0 is moved down and the zero imaginary parts are filled in
+				T* reals = reinterpret_cast<T*>(ArrayX_NumC_out_.derived().data());
+				Eigen::Map<Eigen::ArrayX<T>>(reals + 1, static_cast<Eigen::Index>(size)) = ArrayX_NumF;
+				T scaling_factor = do_inverse ? static_cast<T>(1.0 / size) : static_cast<T>(1);
+				this->r2c_plan<T>(size)->exec(reals + 1, scaling_factor, true);
+				reals[0] = reals[1];
+				reals[1] = 0;
+				if (size % 2 == 0) { reals[size + 1] = 0; }
+				if (do_inverse) { ArrayX_NumC_out_ = ArrayX_NumC_out_.conjugate(); }
+			}
+
+			template <typename Derived>
+			auto r2c(const Eigen::ArrayBase<Derived>& ArrayX_NumF, bool do_inverse = false) {
+				Eigen::ArrayX<std::complex<typename Eigen::ArrayBase<Derived>::Scalar>> result;
+				this->r2c(ArrayX_NumF, result, do_inverse);
+				return result;
+			}
+
+			// Transforms contiguous complex data in place, the inverse is scaled by 1 / size
+			template <typename Derived>
+			void c2c_inplace(const Eigen::ArrayBase<Derived>& ArrayX_NumC_inplace, bool do_inverse = false) {
+				using T = typename Eigen::ArrayBase<Derived>::Scalar::value_type;
+				Eigen::ArrayBase<Derived>& ArrayX_NumC_inplace_ = const_cast<Eigen::ArrayBase<Derived>&>(ArrayX_NumC_inplace);
+				size_t size = static_cast<size_t>(ArrayX_NumC_inplace_.size());
+				if (size == 0) { return; }
+				T scaling_factor = do_inverse ? static_cast<T>(1.0 / size) : static_cast<T>(1);
+				this->c2c_plan<T>(size)->exec(reinterpret_cast<pfft::detail::cmplx<T>*>(ArrayX_NumC_inplace_.derived().data()), scaling_factor, !do_inverse);
+			}
+
+			// Transforms into ArrayX_NumC_out, which is only reallocated when its size changes
+			template <typename DerivedIn, typename DerivedOut>
+			void c2c(const Eigen::ArrayBase<DerivedIn>& ArrayX_NumC, const Eigen::ArrayBase<DerivedOut>& ArrayX_NumC_out, bool do_inverse = false) {
+				Eigen::ArrayBase<DerivedOut>& ArrayX_NumC_out_ = const_cast<Eigen::ArrayBase<DerivedOut>&>(ArrayX_NumC_out);
+				ArrayX_NumC_out_.derived().resize(ArrayX_NumC.size());
+				ArrayX_NumC_out_ = ArrayX_NumC;
+				this->c2c_inplace(ArrayX_NumC_out_, do_inverse);
+			}
+
+			template <typename Derived>
+			auto c2c(const Eigen::ArrayBase<Derived>& ArrayX_NumC, bool do_inverse = false) {
+				Eigen::ArrayX<typename Eigen::ArrayBase<Derived>::Scalar> result;
+				this->c2c(ArrayX_NumC, result, do_inverse);
+				return result;
+			}
+
+			size_t num_plans() {
+				std::lock_guard<std::mutex> lock(plans_mutex);
+				return plans.size();
+			}
+
+			void clear() {
+				std::lock_guard<std::mutex> lock(plans_mutex);
+				plans.clear();
+			}
+
+		private:
+
+			enum class Transform { Real, Complex };
+
+			template <typename Plan, typename T>
+			std::shared_ptr<const Plan> plan(size_t size, Transform transform) {
+				std::tuple<size_t, Transform, std::type_index> key{ size, transform, std::type_index(typeid(T)) };
+				std::lock_guard<std::mutex> lock(plans_mutex);
+				auto it = plans.find(key);
+				if (it == plans.end()) {
+					it = plans.emplace(key, std::make_shared<const Plan>(size)).first;
+				}
+				return std::static_pointer_cast<const Plan>(it->second);
+			}
+
+			std::mutex plans_mutex;
+			std::map<std::tuple<size_t, Transform, std::type_index>, std::shared_ptr<const void>> plans;
+		};
+
+		inline FFTContext& default_fft_context() {
+			static FFTContext context;
+			return context;
+		}
+
+		// A single 1D transform runs on one thread, num_threads is kept for interface compatibility
 		template <typename Derived>
-		auto r2c(const Eigen::ArrayBase<Derived>& ArrayX_NumF, bool do_inverse = false, const size_t& num_threads = 1) {
-			using T = typename Eigen::ArrayBase<Derived>::Scalar;
-			pfft::shape_t axes{ static_cast<size_t>(0) };
-			pfft::shape_t shape_in{ static_cast<size_t>(ArrayX_NumF.size())};
-			pfft::stride_t stride_in{ static_cast<ptrdiff_t>(sizeof(T)) };
-			pfft::stride_t stride_out{ static_cast<ptrdiff_t>(sizeof(std::complex<T>)) };
-			Eigen::ArrayX<std::complex<T>> result(ArrayX_NumF.size() / 2 + 1);
-			T scaling_factor = do_inverse ? static_cast<T>(1.0 / ArrayX_NumF.size()) : static_cast<T>(1);
-			pfft::r2c(shape_in, stride_in, stride_out, axes, !do_inverse, ArrayX_NumF.derived().data(), result.data(), scaling_factor, num_threads);
-			return std::move(result);
+		auto r2c(const Eigen::ArrayBase<Derived>& ArrayX_NumF, bool do_inverse = false, [[maybe_unused]] const size_t& num_threads = 1) {
+			return default_fft_context().r2c(ArrayX_NumF, do_inverse);
 		}
 
 		template <typename Derived>
@@ -48,15 +151,48 @@ namespace Cyn {
 		}
 
 		template <typename Derived>
-		auto c2c(const Eigen::ArrayBase<Derived>& ArrayX_NumC, bool do_inverse = false, const size_t& num_threads = 1) {
+		auto c2c(const Eigen::ArrayBase<Derived>& ArrayX_NumC, bool do_inverse = false, [[maybe_unused]] const size_t& num_threads = 1) {
+			return default_fft_context().c2c(ArrayX_NumC, do_inverse);
+		}
+
+		// pocketfft shape and byte strides of a 2D array with direct access, row index first
+		template <typename Derived>
+		void shape_and_strides(const Eigen::ArrayBase<Derived>& ArrayXX, pfft::shape_t& shape, pfft::stride_t& stride) {
+			using T = typename Eigen::ArrayBase<Derived>::Scalar;
+			shape = { static_cast<size_t>(ArrayXX.rows()), static_cast<size_t>(ArrayXX.cols()) };
+			stride = { static_cast<ptrdiff_t>(ArrayXX.derived().rowStride() * sizeof(T)), static_cast<ptrdiff_t>(ArrayXX.derived().colStride() * sizeof(T)) };
+		}
+
+		// Transforms every column (axis 0) or every row (axis 1) of ArrayXX_NumF in one call, frames are spread over
+		// num_threads threads
+		template <typename Derived>
+		auto r2c_axis(const Eigen::ArrayBase<Derived>& ArrayXX_NumF, size_t axis, bool do_inverse = false, const size_t& num_threads = 1) {
+			using T = typename Eigen::ArrayBase<Derived>::Scalar;
+			Eigen::Index size = axis == 0 ? ArrayXX_NumF.rows() : ArrayXX_NumF.cols();
+			Eigen::ArrayXX<std::complex<T>> result(axis == 0 ? size / 2 + 1 : ArrayXX_NumF.rows(), axis == 0 ? ArrayXX_NumF.cols() : size / 2 + 1);
+			if (ArrayXX_NumF.size() == 0) { return result; }
+			pfft::shape_t shape_in, shape_out;
+			pfft::stride_t stride_in, stride_out;
+			shape_and_strides(ArrayXX_NumF, shape_in, stride_in);
+			shape_and_strides(result, shape_out, stride_out);
+			T scaling_factor = do_inverse ? static_cast<T>(1.0 / size) : static_cast<T>(1);
+			pfft::r2c(shape_in, stride_in, stride_out, axis, !do_inverse, ArrayXX_NumF.derived().data(), result.data(), scaling_factor, num_threads);
+			return result;
+		}
+
+		template <typename Derived>
+		auto c2c_axis(const Eigen::ArrayBase<Derived>& ArrayXX_NumC, size_t axis, bool do_inverse = false, const size_t& num_threads = 1) {
 			using T = typename Eigen::ArrayBase<Derived>::Scalar::value_type;
-			pfft::shape_t axes{ static_cast<size_t>(0) };
-			pfft::shape_t shape{ static_cast<size_t>(ArrayX_NumC.size()) };
-			pfft::stride_t stride{ static_cast<ptrdiff_t>(sizeof(std::complex<T>)) };
-			Eigen::ArrayX<std::complex<T>> result(ArrayX_NumC.size());
-			T scaling_factor = do_inverse ? static_cast<T>(1.0 / ArrayX_NumC.size()) : static_cast<T>(1);
-			pfft::c2c(shape, stride, stride, axes, !do_inverse, ArrayX_NumC.derived().data(), result.data(), scaling_factor, num_threads);
-			return std::move(result);
+			Eigen::Index size = axis == 0 ? ArrayXX_NumC.rows() : ArrayXX_NumC.cols();
+			Eigen::ArrayXX<std::complex<T>> result(ArrayXX_NumC.rows(), ArrayXX_NumC.cols());
+			if (ArrayXX_NumC.size() == 0) { return result; }
+			pfft::shape_t shape, shape_out;
+			pfft::stride_t stride_in, stride_out;
+			shape_and_strides(ArrayXX_NumC, shape, stride_in);
+			shape_and_strides(result, shape_out, stride_out);
+			T scaling_factor = do_inverse ? static_cast<T>(1.0 / size) : static_cast<T>(1);
+			pfft::c2c(shape, stride_in, stride_out, pfft::shape_t{ axis }, !do_inverse, ArrayXX_NumC.derived().data(), result.data(), scaling_factor, num_threads);
+			return result;
 		}
 
 		// ========================================================================
@@ -13,9 +13,11 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <numeric>
 #include <optional>
 #include <stdexcept>
+#include <utility>
 
 namespace Cyn {
 
@@ -102,6 +104,45 @@ namespace Cyn {
 			return a / gcd(a, b) * b;
 		}
 
+		template<NumF T>
+		inline T approx_gcd(T a, T b, T tolerance) {
+			a = std::abs(a);
+			b = std::abs(b);
+			if (a < b) { std::swap(a, b); }
+			while (b > tolerance) {
+				T remainder = std::fmod(a, b);
+				if (b - remainder <= tolerance) { remainder = 0; }
+				a = b;
+				b = remainder;
+			}
+			return a;
+		}
+
+		template<NumF T>
+		inline std::optional<std::pair<uint64_t, uint64_t>> rationalize(T x, T tolerance, uint64_t max_denominator) {
+			if (!(x >= 0) || !std::isfinite(x)) { return std::nullopt; }
+			// Continued fraction convergents p / q of x, stopping at the first within tolerance
+			long double value = static_cast<long double>(x);
+			long double remainder = value;
+			uint64_t p_prev = 0, q_prev = 1, p = 1, q = 0;
+			while (true) {
+				long double term = std::floor(remainder);
+				if (term * static_cast<long double>(std::max<uint64_t>(p, 1)) > 1e18L) { return std::nullopt; }
+				uint64_t a = static_cast<uint64_t>(term);
+				uint64_t p_next = a * p + p_prev;
+				uint64_t q_next = a * q + q_prev;
+				if (q_next > max_denominator) { return std::nullopt; }
+				p_prev = p;
+				q_prev = q;
+				p = p_next;
+				q = q_next;
+				if (std::abs(value - static_cast<long double>(p) / static_cast<long double>(q)) <= tolerance) { return std::make_pair(p, q); }
+				long double fraction = remainder - term;
+				if (fraction <= 0) { return std::nullopt; }
+				remainder = 1 / fraction;
+			}
+		}
+
 		// ========================================================================
 
 		template<NumA T>
@@ -8,9 +8,64 @@
 #define CYN_WAVE_HPP
 
 #include "CynEigenUtils.h"
+#include "CynWaveCache.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <thread>
 
 namespace Cyn {
 
+	enum class SampleMethod {
+		Direct, // One sin() per wave per timestamp
+		Phasor, // Block phasor recurrence, uniformly spaced timestamps only
+		IFFT,   // Inverse FFT, frequencies must sit on the FFT bin grid of the timestamps
+		NUFFT,  // Non-uniform FFT (Gaussian gridding), arbitrary frequencies, accuracy tied to TOLERANCE
+		Auto    // IFFT when the frequencies are bin aligned, otherwise the cheaper of NUFFT and Phasor
+	};
+
+	enum class InterfereMode {
+		Aligned, // Merge same frequency waves that are in phase or in antiphase
+		Phasor   // Merge all same frequency waves into one by summing them as complex phasors
+	};
+
+	template<NumF WaveT>
+	struct CompactPolicy {
+		bool enabled = false;
+		Eigen::Index max_waves = 4096;  // Compact once a result holds this many waves
+		double growth_ratio = 4.0;      // Or once it grows past this multiple of its largest operand
+		Eigen::Index min_waves = 64;    // Results smaller than this are never compacted for growth alone
+		double rearm_ratio = 2.0;       // Past max_waves, compact again only each time a result grows this many times larger
+		std::optional<WaveT> tolerance = std::nullopt;
+		InterfereMode mode = InterfereMode::Phasor;
+	};
+
+	// Counters are atomic since wave arithmetic may run on several threads at once
+	struct CompactStats {
+		std::atomic<size_t> checks{ 0 };
+		std::atomic<size_t> compactions{ 0 };
+		std::atomic<size_t> waves_in{ 0 };
+		std::atomic<size_t> waves_out{ 0 };
+
+		CompactStats() = default;
+		CompactStats(const CompactStats& other) { *this = other; }
+
+		CompactStats& operator=(const CompactStats& other) {
+			checks = other.checks.load();
+			compactions = other.compactions.load();
+			waves_in = other.waves_in.load();
+			waves_out = other.waves_out.load();
+			return *this;
+		}
+
+		inline size_t waves_saved() const { return waves_in.load() - waves_out.load(); }
+	};
+
 	template<NumF WaveT>
 	class WaveArray : public Eigen::Array<WaveT, Eigen::Dynamic, 3> {
 	public:
@@ -24,6 +79,20 @@ namespace Cyn {
 
 		inline static WaveT SAMPLE_RATE = static_cast<WaveT>(44100);
 		inline static WaveT TOLERANCE = static_cast<WaveT>(DEFAULT_TOLERANCE);
+		inline static SampleMethod SAMPLE_METHOD = SampleMethod::Auto;
+		inline static InterfereMode INTERFERE_MODE = InterfereMode::Aligned;
+		inline static CompactPolicy<WaveT> COMPACT_POLICY{};
+		inline static CompactStats COMPACT_STATS{};
+		inline static Eigen::Index POW_MAX_WAVES = static_cast<Eigen::Index>(1) << 22;
+		inline static RenderCachePolicy<WaveT> RENDER_CACHE_POLICY{};
+		inline static RenderCacheStats RENDER_CACHE_STATS{};
+		inline static bool PERIODIC_TILING = false;
+
+
+		// Class Types
+
+		// Precision used for phase bookkeeping while rendering (at least double)
+		using CalcT = std::common_type_t<WaveT, double>;
 
 
 		// Accessors
@@ -294,41 +363,250 @@ namespace Cyn {
 
 		// Interference
 
-		WaveArray<WaveT> interfere(std::optional<WaveT> tolerance = std::nullopt) const {
+		WaveArray<WaveT> interfere(std::optional<WaveT> tolerance = std::nullopt, std::optional<InterfereMode> mode = std::nullopt) const {
 			Eigen::Index this_num_w = this->num_waves();
 			if (this_num_w == 0 || this_num_w == 1) { return *this; }
 			WaveT tol = tolerance.value_or(TOLERANCE);
-			WaveArray<WaveT> result = this->remove_zero(tol);
+			bool phasor_mode = mode.value_or(INTERFERE_MODE) == InterfereMode::Phasor;
+			WaveArray<WaveT> result;
+			if (phasor_mode) {
+				// Prune after merging, many waves below tolerance can sum to one above it
+				result = *this;
+				for (Eigen::Index i = 0; i < this_num_w; ++i) {
+					if (iszero(result(i, 0), tol)) {
+						result(i, 0) = 0;
+					}
+					else if (result(i, 0) < 0) {
+						result(i, 0) = -result(i, 0);
+						result(i, 2) = pi<WaveT>() - result(i, 2);
+					}
+				}
+			}
+			else {
+				result = this->remove_zero(tol);
+				if (result.num_waves() <= 1) { return result; }
+				result.standardize_params_inplace(tol);
+			}
 			Eigen::Index num_w = result.num_waves();
-			if (num_w == 0 || num_w == 1) { return result; }
-			result.standardize_params_inplace(tol);
-			auto freq_arr = result.freq().replicate(1, num_w);
-			auto phase_arr = result.phase().replicate(1, num_w);
-			Eigen::MatrixXb same_freq(num_w, num_w), constructive(num_w, num_w), destructive(num_w, num_w);
-			constructive.diagonal().setOnes();
-			constructive.triangularView<Eigen::StrictlyUpper>().setZero();
-			destructive.triangularView<Eigen::Upper>().setZero();
-			same_freq.triangularView<Eigen::StrictlyLower>() = freq_arr.isclose(freq_arr.transpose(), tol).matrix();
-			constructive.triangularView<Eigen::StrictlyLower>() = phase_arr.isclose(phase_arr.transpose(), tol).matrix() && same_freq;
-			destructive.triangularView<Eigen::StrictlyLower>() = phase_arr.isclose((phase_arr.transpose() - pi<WaveT>()).posmod(pi<WaveT>(2.0L)), tol).matrix() && same_freq;
-			result.amp() = (constructive.cast<WaveT>().array().colwise() * result.amp()).colwise().sum() - (destructive.cast<WaveT>().array().colwise() * result.amp()).colwise().sum();
-			constructive.diagonal().setZero();
-			return result.filter(!((constructive || destructive).rowwise().any().array() || result.amp().iszero(tol)));
+			// Waves pi apart share a phase key and interfere with opposite signs
+			Eigen::ArrayX<WaveT> phase_key(phasor_mode ? 0 : num_w);
+			Eigen::ArrayX<WaveT> phase_sign(phasor_mode ? 0 : num_w);
+			for (Eigen::Index i = 0; i < phase_key.size(); ++i) {
+				WaveT key = result(i, 2);
+				WaveT sign = static_cast<WaveT>(1);
+				if (key >= pi<WaveT>()) {
+					key -= pi<WaveT>();
+					sign = -sign;
+				}
+				if (key > pi<WaveT>() - tol) {
+					key -= pi<WaveT>();
+					sign = -sign;
+				}
+				phase_key(i) = key;
+				phase_sign(i) = sign;
+			}
+			std::vector<Eigen::Index> idx(num_w);
+			std::iota(idx.begin(), idx.end(), 0);
+			std::sort(idx.begin(), idx.end(), [&](Eigen::Index a, Eigen::Index b) {
+					return result(a, 0) < result(b, 0) || (result(a, 0) == result(b, 0) && a < b);
+				}
+			);
+			// Each group of equal frequency (and equal phase key when aligned) collapses onto its earliest row
+			Eigen::ArrayXb keep = Eigen::ArrayXb::Zero(num_w);
+			Eigen::Index freq_start = 0;
+			while (freq_start < num_w) {
+				Eigen::Index freq_end = freq_start + 1;
+				while (freq_end < num_w && result(idx[freq_end], 0) - result(idx[freq_start], 0) < tol) { ++freq_end; }
+				if (phasor_mode) {
+					// a * sin(2 pi f t - phase) is the imaginary part of a * e^(-i phase) * e^(i 2 pi f t)
+					std::complex<CalcT> phasor(0, 0);
+					for (Eigen::Index j = freq_start; j < freq_end; ++j) {
+						CalcT amp = static_cast<CalcT>(result(idx[j], 1));
+						CalcT phase = static_cast<CalcT>(result(idx[j], 2));
+						phasor += std::complex<CalcT>(amp * std::cos(phase), -amp * std::sin(phase));
+					}
+					Eigen::Index anchor = *std::min_element(idx.begin() + freq_start, idx.begin() + freq_end);
+					result(anchor, 1) = static_cast<WaveT>(std::abs(phasor));
+					result(anchor, 2) = posmod(static_cast<WaveT>(-std::arg(phasor)), pi<WaveT>(2.0L));
+					keep(anchor) = !iszero(result(anchor, 1), tol);
+					freq_start = freq_end;
+					continue;
+				}
+				std::sort(idx.begin() + freq_start, idx.begin() + freq_end, [&](Eigen::Index a, Eigen::Index b) {
+						return phase_key(a) < phase_key(b) || (phase_key(a) == phase_key(b) && a < b);
+					}
+				);
+				Eigen::Index phase_start = freq_start;
+				while (phase_start < freq_end) {
+					Eigen::Index phase_end = phase_start + 1;
+					while (phase_end < freq_end && phase_key(idx[phase_end]) - phase_key(idx[phase_start]) < tol) { ++phase_end; }
+					Eigen::Index anchor = *std::min_element(idx.begin() + phase_start, idx.begin() + phase_end);
+					WaveT amp_sum = static_cast<WaveT>(0);
+					for (Eigen::Index j = phase_start; j < phase_end; ++j) {
+						amp_sum += phase_sign(idx[j]) * result(idx[j], 1);
+					}
+					result(anchor, 1) = phase_sign(anchor) * amp_sum;
+					keep(anchor) = !iszero(result(anchor, 1), tol);
+					phase_start = phase_end;
+				}
+				freq_start = freq_end;
+			}
+			return result.filter(keep);
+		}
+
+		// Compaction
+
+		inline WaveArray<WaveT> compact(std::optional<CompactPolicy<WaveT>> policy = std::nullopt) const {
+			CompactPolicy<WaveT> pol = policy.value_or(COMPACT_POLICY);
+			return this->interfere(pol.tolerance, pol.mode);
+		}
+
+		// Index k of the band [max_waves * rearm_ratio^k, max_waves * rearm_ratio^(k+1)) holding num_w, -1 below max_waves
+		static int compact_band(Eigen::Index num_w, const CompactPolicy<WaveT>& pol) {
+			if (num_w < pol.max_waves) { return -1; }
+			int band = 0;
+			for (double bound = pol.rearm_ratio * static_cast<double>(std::max<Eigen::Index>(pol.max_waves, 1)); static_cast<double>(num_w) >= bound; bound *= pol.rearm_ratio) { ++band; }
+			return band;
+		}
+
+		// Applies the policy to the result of an operation whose largest operand held operand_num_waves waves
+		bool auto_compact_inplace(Eigen::Index operand_num_waves, std::optional<CompactPolicy<WaveT>> policy = std::nullopt) {
+			const CompactPolicy<WaveT>& pol = policy.has_value() ? policy.value() : COMPACT_POLICY;
+			if (!pol.enabled) { return false; }
+			++COMPACT_STATS.checks;
+			Eigen::Index num_w = this->num_waves();
+			// Sizes past max_waves fall into bands max_waves * rearm_ratio^k, a result is only compacted for its size when
+			// it lands in a higher band than its largest operand. Accumulating many small terms onto an array that does not
+			// compact below max_waves then re-merges it once per band instead of on every operation.
+			bool too_many = num_w >= pol.max_waves && (pol.rearm_ratio <= 1.0 || compact_band(num_w, pol) > compact_band(operand_num_waves, pol));
+			bool grew = num_w >= pol.min_waves && static_cast<double>(num_w) >= pol.growth_ratio * static_cast<double>(operand_num_waves);
+			if (!(too_many || grew)) { return false; }
+			*this = this->interfere(pol.tolerance, pol.mode);
+			++COMPACT_STATS.compactions;
+			COMPACT_STATS.waves_in += static_cast<size_t>(num_w);
+			COMPACT_STATS.waves_out += static_cast<size_t>(this->num_waves());
+			return true;
+		}
+
+		// Power
+
+		// Exponentiation by squaring, merging same frequency waves and pruning zero waves after every product
+		WaveArray<WaveT> pow(Eigen::Index exponent, std::optional<WaveT> tolerance = std::nullopt, std::optional<Eigen::Index> max_waves = std::nullopt) const {
+			if (exponent < 0) { throw std::invalid_argument("Exponent must be non-negative."); }
+			if (exponent == 0) { return one(); }
+			Eigen::Index max_w = max_waves.value_or(POW_MAX_WAVES);
+			auto checked_product = [&](const WaveArray<WaveT>& lhs, const WaveArray<WaveT>& rhs) {
+				if (2 * lhs.num_waves() * rhs.num_waves() > max_w) {
+					throw std::length_error("Power exceeds max_waves, raise max_waves or prune the base wave.");
+				}
+				WaveArray<WaveT> product;
+				multiply_into(product, lhs, rhs);
+				return product.interfere(tolerance, InterfereMode::Phasor);
+			};
+			WaveArray<WaveT> base = this->interfere(tolerance, InterfereMode::Phasor);
+			std::optional<WaveArray<WaveT>> result;
+			while (true) {
+				if (exponent & 1) {
+					result = result.has_value() ? checked_product(result.value(), base) : base;
+				}
+				exponent >>= 1;
+				if (exponent == 0) { break; }
+				base = checked_product(base, base);
+			}
+			return result.value();
 		}
 
 		// WaveArray Standardization
 
-		inline WaveArray<WaveT> standardize(std::optional<WaveT> tolerance = std::nullopt) const {
-			WaveArray<WaveT> interfered = this->interfere(tolerance);
+		inline WaveArray<WaveT> standardize(std::optional<WaveT> tolerance = std::nullopt, std::optional<InterfereMode> mode = std::nullopt) const {
+			WaveArray<WaveT> interfered = this->interfere(tolerance, mode);
 			interfered.standardize_params_inplace(tolerance);
 			return interfered.sort(0, true, tolerance);
 		}
 
+		// Hashing
+
+		// The waves' parameters as rows in a canonical order, phases taken mod 2 pi. With a tolerance every parameter
+		// is replaced by the index of the multiple of it it rounds to, so waves that round alike give equal rows.
+		std::vector<std::array<WaveT, 3>> content_rows(std::optional<WaveT> tolerance = std::nullopt) const {
+			Eigen::Index num_w = this->num_waves();
+			std::vector<std::array<WaveT, 3>> rows(static_cast<size_t>(num_w));
+			for (Eigen::Index i = 0; i < num_w; ++i) {
+				for (Eigen::Index j = 0; j < 3; ++j) {
+					WaveT value = j == 2 ? posmod(this->operator()(i, j), pi<WaveT>(2.0L)) : this->operator()(i, j);
+					rows[i][j] = tolerance.has_value() ? std::round(value / tolerance.value()) : value;
+				}
+			}
+			// NaNs order after every number to keep the ordering strict weak
+			auto less = [](WaveT a, WaveT b) { return !std::isnan(a) && (std::isnan(b) || a < b); };
+			std::sort(rows.begin(), rows.end(), [&less](const std::array<WaveT, 3>& a, const std::array<WaveT, 3>& b) {
+				return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end(), less);
+			});
+			return rows;
+		}
+
+		// Hash of the waves' content, independent of their order, see content_rows()
+		size_t content_hash(std::optional<WaveT> tolerance = std::nullopt) const {
+			return hash_content_rows(this->content_rows(tolerance));
+		}
+
+
+		// Periodicity
+
+		// Returns the fundamental frequency of the waves, the largest f0 of which every frequency lies within tolerance
+		// (default TOLERANCE, in Hz) of an integer multiple, if one exists with a period of at most max_period seconds.
+		// Frequencies are rationalized and combined as gcd(numerators) / lcm(denominators), zero frequencies are ignored.
+		std::optional<CalcT> fundamental(std::optional<CalcT> tolerance = std::nullopt, std::optional<CalcT> max_period = std::nullopt) const {
+			constexpr uint64_t max_denominator = static_cast<uint64_t>(1) << 20;
+			Eigen::Index num_w = this->num_waves();
+			CalcT tol = tolerance.value_or(static_cast<CalcT>(TOLERANCE));
+			Eigen::Array<uint64_t, Eigen::Dynamic, 1> numerators(num_w), denominators(num_w);
+			uint64_t common_denominator = 1;
+			for (Eigen::Index i = 0; i < num_w; ++i) {
+				std::optional<std::pair<uint64_t, uint64_t>> ratio = rationalize(static_cast<CalcT>(std::abs(this->operator()(i, 0))), tol, max_denominator);
+				if (!ratio.has_value()) { return std::nullopt; }
+				numerators(i) = ratio->first;
+				denominators(i) = ratio->second;
+				if (common_denominator / gcd(common_denominator, denominators(i)) > max_denominator / denominators(i)) { return std::nullopt; }
+				common_denominator = lcm(common_denominator, denominators(i));
+			}
+			numerators *= common_denominator / denominators;
+			uint64_t common_numerator = gcd(numerators);
+			if (common_numerator == 0) { return std::nullopt; }
+			CalcT f0 = static_cast<CalcT>(common_numerator) / static_cast<CalcT>(common_denominator);
+			if (max_period.has_value() && 1 / f0 > max_period.value()) { return std::nullopt; }
+			return f0;
+		}
+
+		// Returns the fundamental period in seconds, see fundamental()
+		std::optional<CalcT> period(std::optional<CalcT> tolerance = std::nullopt, std::optional<CalcT> max_period = std::nullopt) const {
+			std::optional<CalcT> f0 = this->fundamental(tolerance, max_period);
+			if (!f0.has_value()) { return std::nullopt; }
+			return 1 / f0.value();
+		}
+
+
+		// Render Cache
+
+		// Renders cached by samples(duration, ...) while RENDER_CACHE_POLICY.enabled, shared by every WaveArray<WaveT>
+		inline static RenderCache<WaveT>& render_cache() {
+			static RenderCache<WaveT> cache;
+			return cache;
+		}
+
+		inline static void clear_render_cache() {
+			render_cache().clear(RENDER_CACHE_STATS);
+		}
+
+
 		// Sampling
 
+		inline static Eigen::Index num_timestamps(WaveT duration, std::optional<WaveT> sample_rate = std::nullopt) {
+			return static_cast<Eigen::Index>(std::round(duration * sample_rate.value_or(SAMPLE_RATE)));
+		}
+
 		inline static Eigen::ArrayX<WaveT> generate_timestamps(WaveT duration, std::optional<WaveT> sample_rate = std::nullopt) {
-			Eigen::Index num_samples = static_cast<Eigen::Index>(std::round(duration * sample_rate.value_or(SAMPLE_RATE)));
-			return Eigen::ArrayX<WaveT>::LinSpaced(num_samples, 0, duration);
+			return Eigen::ArrayX<WaveT>::LinSpaced(num_timestamps(duration, sample_rate), 0, duration);
 		}
 
 		inline WaveT sample(WaveT timestamp) const {
@@ -348,10 +626,302 @@ namespace Cyn {
 			return result;
 		}
 
-		inline Eigen::ArrayX<WaveT> samples(WaveT duration, std::optional<WaveT> sample_rate = std::nullopt, Eigen::ArrayX<WaveT>* generated_timestamps = nullptr) const {
-			Eigen::ArrayX<WaveT> timestamps = this->generate_timestamps(duration, sample_rate);
-			if (generated_timestamps != nullptr) { *generated_timestamps = timestamps; }
-			return this->samples(timestamps);
+		// Renders num_samples samples at the timestamps start + k * step.
+		// Waves are processed in banks. Each bank builds a table of unit phasors e^(i 2pi f step k) for one block
+		// of samples, so rendering a block is a single matrix-vector product with the bank's current phasors.
+		// Between blocks the phasors are advanced by one block rotation, and every few blocks they are re-anchored
+		// to their exact phase (computed in CalcT) so that recurrence drift stays far below TOLERANCE.
+		Eigen::ArrayX<WaveT> samples_phasor(CalcT start, CalcT step, Eigen::Index num_samples) const {
+			constexpr Eigen::Index bank_size = 512;
+			constexpr Eigen::Index max_block_size = 256;
+			constexpr Eigen::Index blocks_per_anchor = 16;
+			Eigen::Index num_w = this->num_waves();
+			if (num_samples <= 0) { return Eigen::ArrayX<WaveT>(0); }
+			Eigen::ArrayX<WaveT> result = Eigen::ArrayX<WaveT>::Zero(num_samples);
+			if (num_w == 0) { return result; }
+			const CalcT two_pi = pi<CalcT>(2.0L);
+			// Building the table costs one sin/cos per wave per block sample, so short renders use shorter blocks
+			Eigen::Index block_size = std::clamp(static_cast<Eigen::Index>(std::sqrt(static_cast<double>(num_samples))), Eigen::Index(16), max_block_size);
+			Eigen::Index table_size = std::min(block_size, num_samples);
+			Eigen::ArrayX<CalcT> table_steps = Eigen::ArrayX<CalcT>::LinSpaced(table_size, 0, static_cast<CalcT>(table_size - 1));
+			Eigen::ArrayXX<CalcT> table_cycles;
+			Eigen::Matrix<WaveT, Eigen::Dynamic, Eigen::Dynamic> table_re, table_im;
+			Eigen::Matrix<WaveT, Eigen::Dynamic, 1> block_result(table_size);
+			Eigen::ArrayX<CalcT> freq, phase, cycles;
+			Eigen::ArrayX<WaveT> amp, theta, z_re, z_im, next_re, rot_re, rot_im;
+			for (Eigen::Index bank_start = 0; bank_start < num_w; bank_start += bank_size) {
+				Eigen::Index bank_num_w = std::min(bank_size, num_w - bank_start);
+				freq = this->freq().segment(bank_start, bank_num_w).template cast<CalcT>();
+				phase = this->phase().segment(bank_start, bank_num_w).template cast<CalcT>();
+				amp = this->amp().segment(bank_start, bank_num_w);
+				cycles = freq * step;
+				cycles -= cycles.floor();
+				table_cycles = (cycles.matrix() * table_steps.matrix().transpose()).array();
+				table_cycles = (table_cycles - table_cycles.floor()) * two_pi;
+				table_re = table_cycles.template cast<WaveT>().cos().matrix();
+				table_im = table_cycles.template cast<WaveT>().sin().matrix();
+				cycles *= static_cast<CalcT>(table_size);
+				theta = ((cycles - cycles.floor()) * two_pi).template cast<WaveT>();
+				rot_re = theta.cos();
+				rot_im = theta.sin();
+				for (Eigen::Index block_start = 0, block_idx = 0; block_start < num_samples; block_start += table_size, ++block_idx) {
+					if (block_idx % blocks_per_anchor == 0) {
+						cycles = freq * (start + step * static_cast<CalcT>(block_start));
+						theta = ((cycles - cycles.floor()) * two_pi - phase).template cast<WaveT>();
+						z_re = amp * theta.cos();
+						z_im = amp * theta.sin();
+					}
+					else {
+						next_re = z_re * rot_re - z_im * rot_im;
+						z_im = z_re * rot_im + z_im * rot_re;
+						z_re.swap(next_re);
+					}
+					// Im(z e^(i a)) = Re(z) sin(a) + Im(z) cos(a)
+					Eigen::Index block_num_samples = std::min(table_size, num_samples - block_start);
+					block_result.head(block_num_samples).noalias() = table_im.leftCols(block_num_samples).transpose() * z_re.matrix();
+					block_result.head(block_num_samples).noalias() += table_re.leftCols(block_num_samples).transpose() * z_im.matrix();
+					result.segment(block_start, block_num_samples) += block_result.head(block_num_samples).array();
+				}
+			}
+			return result;
+		}
+
+		// Returns the smallest FFT size M for which every wave completes an integer number of cycles every M samples
+		// of spacing step, if such an M exists. Frequencies count as aligned when snapping them to the M bin grid
+		// drifts their phase by less than tolerance cycles over num_samples samples.
+		std::optional<Eigen::Index> fft_grid_size(CalcT step, Eigen::Index num_samples, std::optional<WaveT> tolerance = std::nullopt) const {
+			Eigen::Index num_w = this->num_waves();
+			if (num_w == 0 || num_samples <= 0) { return std::nullopt; }
+			CalcT tol = tolerance.value_or(TOLERANCE);
+			CalcT cycle_tol = tol / static_cast<CalcT>(num_samples);
+			Eigen::Index max_size = std::max<Eigen::Index>(4 * num_samples, Eigen::Index(1) << 16);
+			Eigen::ArrayX<CalcT> cycles = this->freq().template cast<CalcT>() * step;
+			cycles -= cycles.floor();
+			CalcT grid = 1;
+			for (Eigen::Index i = 0; i < num_w; ++i) {
+				if (cycles(i) <= cycle_tol || cycles(i) >= 1 - cycle_tol) { continue; }
+				grid = approx_gcd(grid, cycles(i), cycle_tol);
+				if (grid * static_cast<CalcT>(max_size) < 1) { return std::nullopt; }
+			}
+			Eigen::Index fft_size = static_cast<Eigen::Index>(std::round(1 / grid));
+			cycles *= static_cast<CalcT>(fft_size);
+			if (((cycles - cycles.round()).abs() * (static_cast<CalcT>(num_samples) / static_cast<CalcT>(fft_size))).maxCoeff() > tol) { return std::nullopt; }
+			return fft_size;
+		}
+
+		// Returns the smallest number of samples of spacing step after which every wave repeats, if the waves share a
+		// fundamental and the signal repeats at least twice within num_samples samples. Repeats count when tiling them
+		// drifts every wave's phase by less than tolerance cycles over num_samples samples, as in fft_grid_size.
+		std::optional<Eigen::Index> period_size(CalcT step, Eigen::Index num_samples, std::optional<WaveT> tolerance = std::nullopt) const {
+			if (this->num_waves() == 0 || num_samples < 2 || !(step > 0)) { return std::nullopt; }
+			CalcT tol = tolerance.value_or(TOLERANCE);
+			CalcT cycle_tol = tol / static_cast<CalcT>(num_samples);
+			std::optional<CalcT> f0 = this->fundamental(cycle_tol / step, step * static_cast<CalcT>(num_samples / 2));
+			if (!f0.has_value()) { return std::nullopt; }
+			// The highest harmonic drifts the most, so f0 is matched that many times tighter
+			CalcT max_harmonic = this->freq().abs().maxCoeff() / f0.value();
+			std::optional<std::pair<uint64_t, uint64_t>> ratio = rationalize(f0.value() * step, cycle_tol / max_harmonic, static_cast<uint64_t>(num_samples / 2));
+			if (!ratio.has_value() || ratio->first == 0) { return std::nullopt; }
+			Eigen::Index size = static_cast<Eigen::Index>(ratio->second);
+			Eigen::ArrayX<CalcT> cycles = this->freq().template cast<CalcT>() * (step * static_cast<CalcT>(size));
+			if (((cycles - cycles.round()).abs() * (static_cast<CalcT>(num_samples) / static_cast<CalcT>(size))).maxCoeff() > tol) { return std::nullopt; }
+			return size;
+		}
+
+		// Repeats period until num_samples samples are filled
+		inline static Eigen::ArrayX<WaveT> tile(const Eigen::ArrayX<WaveT>& period, Eigen::Index num_samples) {
+			Eigen::Index period_size = period.size();
+			Eigen::ArrayX<WaveT> result(num_samples);
+			for (Eigen::Index tile_start = 0; tile_start < num_samples; tile_start += period_size) {
+				Eigen::Index tile_size = std::min(period_size, num_samples - tile_start);
+				result.segment(tile_start, tile_size) = period.head(tile_size);
+			}
+			return result;
+		}
+
+		// Renders num_samples samples at the timestamps start + k * step by accumulating every wave into its FFT bin
+		// and running a single inverse transform of fft_size points, which is then tiled. Throws if the frequencies
+		// are not aligned to the grid (fft_size defaults to fft_grid_size()).
+		Eigen::ArrayX<WaveT> samples_ifft(CalcT start, CalcT step, Eigen::Index num_samples, std::optional<Eigen::Index> fft_size = std::nullopt) const {
+			if (num_samples <= 0) { return Eigen::ArrayX<WaveT>(0); }
+			if (!fft_size.has_value()) {
+				fft_size = this->fft_grid_size(step, num_samples);
+				if (!fft_size.has_value()) {
+					throw std::invalid_argument("Wave frequencies are not aligned to an FFT bin grid for this sample spacing.");
+				}
+			}
+			Eigen::Index grid_size = fft_size.value();
+			if (grid_size <= 0) { throw std::invalid_argument("fft_size must be positive."); }
+			Eigen::Index num_w = this->num_waves();
+			Eigen::ArrayX<std::complex<CalcT>> spectrum = Eigen::ArrayX<std::complex<CalcT>>::Zero(grid_size);
+			Eigen::ArrayX<CalcT> freq = this->freq().template cast<CalcT>();
+			Eigen::ArrayX<CalcT> bins = freq * step;
+			bins = ((bins - bins.floor()) * static_cast<CalcT>(grid_size)).round();
+			Eigen::ArrayX<CalcT> theta = freq * start;
+			theta = (theta - theta.floor()) * pi<CalcT>(2.0L) - this->phase().template cast<CalcT>();
+			for (Eigen::Index i = 0; i < num_w; ++i) {
+				spectrum(static_cast<Eigen::Index>(bins(i)) % grid_size) += std::polar(static_cast<CalcT>(this->operator()(i, 1)), theta(i));
+			}
+			Eigen::ArrayX<WaveT> period = (FFT::c2c(spectrum, true).imag() * static_cast<CalcT>(grid_size)).template cast<WaveT>();
+			return tile(period, num_samples);
+		}
+
+		// Gaussian gridding parameters used by samples_nufft: kernel half width and segment length
+		void nufft_plan(Eigen::Index num_samples, std::optional<WaveT> accuracy, Eigen::Index& spread_width, Eigen::Index& segment_size) const {
+			CalcT amp_sum = this->amp().abs().template cast<CalcT>().sum();
+			CalcT rel_accuracy = static_cast<CalcT>(accuracy.value_or(TOLERANCE)) / std::max(amp_sum, static_cast<CalcT>(1));
+			spread_width = std::clamp(static_cast<Eigen::Index>(std::ceil(-std::log10(rel_accuracy))) + 1, Eigen::Index(2), Eigen::Index(16));
+			segment_size = static_cast<Eigen::Index>(std::bit_ceil(static_cast<size_t>(std::max<Eigen::Index>(this->num_waves() * spread_width, 1))));
+			segment_size = std::clamp(segment_size, Eigen::Index(1) << 10, Eigen::Index(1) << 20);
+			segment_size = std::min(segment_size, static_cast<Eigen::Index>(std::bit_ceil(static_cast<size_t>(std::max<Eigen::Index>(num_samples, 64)))));
+		}
+
+		// Renders num_samples samples at the timestamps start + k * step with a type-1 non-uniform FFT.
+		// The output is cut into segments of B samples. For each segment the waves' phasors are spread onto a 2B point
+		// grid with a truncated Gaussian (fast Gaussian gridding, Greengard & Lee 2004), transformed with one FFT::c2c,
+		// and deconvolved by the Gaussian's Fourier transform. The error is about accuracy (defaults to TOLERANCE)
+		// per unit of total amplitude, and the cost is O(N w + T log B) per segment instead of O(N T).
+		Eigen::ArrayX<WaveT> samples_nufft(CalcT start, CalcT step, Eigen::Index num_samples, std::optional<WaveT> accuracy = std::nullopt) const {
+			if (num_samples <= 0) { return Eigen::ArrayX<WaveT>(0); }
+			Eigen::ArrayX<WaveT> result = Eigen::ArrayX<WaveT>::Zero(num_samples);
+			Eigen::Index num_w = this->num_waves();
+			if (num_w == 0) { return result; }
+			Eigen::Index spread_width, segment_size;
+			this->nufft_plan(num_samples, accuracy, spread_width, segment_size);
+			const CalcT two_pi = pi<CalcT>(2.0L);
+			Eigen::Index grid_size = 2 * segment_size;
+			Eigen::Index half_segment = segment_size / 2;
+			CalcT grid_step = two_pi / static_cast<CalcT>(grid_size);
+			CalcT tau = pi<CalcT>() * static_cast<CalcT>(spread_width) / (static_cast<CalcT>(segment_size) * static_cast<CalcT>(segment_size) * 3);
+
+			// Per wave: grid position x = 2pi frac(-f step) such that e^(-i k x) = e^(i 2pi f step k)
+			Eigen::ArrayX<CalcT> freq = this->freq().template cast<CalcT>();
+			Eigen::ArrayX<CalcT> phase = this->phase().template cast<CalcT>();
+			Eigen::ArrayX<CalcT> amp = this->amp().template cast<CalcT>();
+			Eigen::ArrayX<CalcT> cycles = -freq * step;
+			cycles -= cycles.floor();
+			Eigen::ArrayX<CalcT> grid_pos = cycles * static_cast<CalcT>(grid_size);
+			Eigen::ArrayX<CalcT> grid_idx = grid_pos.floor();
+			Eigen::ArrayX<CalcT> offset = (grid_pos - grid_idx) * grid_step;
+			Eigen::ArrayX<CalcT> e1 = (-offset.square() / (4 * tau)).exp();
+			Eigen::ArrayX<CalcT> e2 = (offset * (grid_step / (2 * tau))).exp();
+			Eigen::ArrayX<CalcT> e2_inv = e2.inverse();
+			Eigen::ArrayX<CalcT> e3(spread_width + 1);
+			for (Eigen::Index j = 0; j <= spread_width; ++j) {
+				e3(j) = std::exp(-(static_cast<CalcT>(j) * grid_step) * (static_cast<CalcT>(j) * grid_step) / (4 * tau));
+			}
+			// Deconvolution of the Gaussian for modes k = -B/2 .. B/2 - 1
+			Eigen::ArrayX<CalcT> modes = Eigen::ArrayX<CalcT>::LinSpaced(segment_size, static_cast<CalcT>(-half_segment), static_cast<CalcT>(segment_size - half_segment - 1));
+			Eigen::ArrayX<CalcT> deconvolve = (modes.square() * tau).exp() * (std::sqrt(pi<CalcT>() / tau) / static_cast<CalcT>(grid_size));
+
+			Eigen::ArrayX<std::complex<CalcT>> grid(grid_size), spectrum;
+			Eigen::ArrayX<CalcT> theta, z_re, z_im;
+			for (Eigen::Index segment_start = 0; segment_start < num_samples; segment_start += segment_size) {
+				// Phasors at the segment's mode k = 0, i.e. sample segment_start + B/2
+				theta = freq * (start + step * static_cast<CalcT>(segment_start + half_segment));
+				theta = (theta - theta.floor()) * two_pi - phase;
+				z_re = amp * theta.cos();
+				z_im = amp * theta.sin();
+				grid.setZero();
+				for (Eigen::Index i = 0; i < num_w; ++i) {
+					Eigen::Index center = static_cast<Eigen::Index>(grid_idx(i));
+					std::complex<CalcT> z(z_re(i), z_im(i));
+					z *= e1(i);
+					std::complex<CalcT> z_down = z;
+					grid((center + grid_size) % grid_size) += z;
+					for (Eigen::Index j = 1; j <= spread_width; ++j) {
+						z *= e2(i);
+						z_down *= e2_inv(i);
+						grid((center + j) % grid_size) += z * e3(j);
+						if (j < spread_width) { grid((center - j + grid_size) % grid_size) += z_down * e3(j); }
+					}
+				}
+				FFT::default_context().c2c(grid, spectrum);
+				Eigen::Index segment_num_samples = std::min(segment_size, num_samples - segment_start);
+				for (Eigen::Index k = 0; k < segment_num_samples; ++k) {
+					Eigen::Index mode = k - half_segment;
+					result(segment_start + k) = static_cast<WaveT>(spectrum((mode + grid_size) % grid_size).imag() * deconvolve(k));
+				}
+			}
+			return result;
+		}
+
+		// Consults the render cache first while RENDER_CACHE_POLICY.enabled, renders are keyed by content_rows() with the
+		// policy's tolerance, the duration, the sample rate, the method, the number of samples, TOLERANCE and PERIODIC_TILING
+		inline Eigen::ArrayX<WaveT> samples(WaveT duration, std::optional<WaveT> sample_rate = std::nullopt, Eigen::ArrayX<WaveT>* generated_timestamps = nullptr, std::optional<SampleMethod> method = std::nullopt) const {
+			if (generated_timestamps != nullptr) { *generated_timestamps = this->generate_timestamps(duration, sample_rate); }
+			if (!RENDER_CACHE_POLICY.enabled) {
+				return this->samples_uncached(duration, sample_rate, generated_timestamps, method);
+			}
+			RenderKey<WaveT> key{ this->content_rows(RENDER_CACHE_POLICY.tolerance), duration, sample_rate.value_or(SAMPLE_RATE),
+				static_cast<size_t>(method.value_or(SAMPLE_METHOD)), num_timestamps(duration, sample_rate), TOLERANCE, PERIODIC_TILING };
+			Eigen::ArrayX<WaveT> result;
+			if (render_cache().find(key, result, RENDER_CACHE_STATS)) { return result; }
+			result = this->samples_uncached(duration, sample_rate, generated_timestamps, method);
+			render_cache().insert(key, result, RENDER_CACHE_POLICY.max_bytes, RENDER_CACHE_STATS);
+			return result;
+		}
+
+		// samples(duration, ...) without the render cache, generated_timestamps must already hold the timestamps if given
+		inline Eigen::ArrayX<WaveT> samples_uncached(WaveT duration, std::optional<WaveT> sample_rate = std::nullopt, const Eigen::ArrayX<WaveT>* generated_timestamps = nullptr, std::optional<SampleMethod> method = std::nullopt) const {
+			if (method.value_or(SAMPLE_METHOD) == SampleMethod::Direct && !PERIODIC_TILING) {
+				if (generated_timestamps != nullptr) { return this->samples(*generated_timestamps); }
+				return this->samples(this->generate_timestamps(duration, sample_rate));
+			}
+			// Same grid as generate_timestamps, LinSpaced over [0, duration] (a lone sample sits at duration)
+			Eigen::Index num_samples = this->num_timestamps(duration, sample_rate);
+			CalcT start = num_samples == 1 ? static_cast<CalcT>(duration) : static_cast<CalcT>(0);
+			CalcT step = num_samples > 1 ? static_cast<CalcT>(duration) / static_cast<CalcT>(num_samples - 1) : static_cast<CalcT>(0);
+			return this->samples_uniform(start, step, num_samples, method);
+		}
+
+		// Renders num_samples samples at the timestamps start + k * step with the given (or default) method. While
+		// PERIODIC_TILING is set and the signal repeats within the render (see period_size), only one repeat is
+		// rendered and then tiled.
+		Eigen::ArrayX<WaveT> samples_uniform(CalcT start, CalcT step, Eigen::Index num_samples, std::optional<SampleMethod> method = std::nullopt) const {
+			if (PERIODIC_TILING) {
+				std::optional<Eigen::Index> size = this->period_size(step, num_samples);
+				if (size.has_value()) {
+					return tile(this->samples_uniform_once(start, step, size.value(), method), num_samples);
+				}
+			}
+			return this->samples_uniform_once(start, step, num_samples, method);
+		}
+
+		// samples_uniform without periodic tiling
+		Eigen::ArrayX<WaveT> samples_uniform_once(CalcT start, CalcT step, Eigen::Index num_samples, std::optional<SampleMethod> method = std::nullopt) const {
+			SampleMethod sample_method = method.value_or(SAMPLE_METHOD);
+			switch (sample_method) {
+			case SampleMethod::Direct: {
+				Eigen::ArrayX<CalcT> timestamps = Eigen::ArrayX<CalcT>::LinSpaced(num_samples, 0, static_cast<CalcT>(num_samples - 1)) * step + start;
+				return this->samples(timestamps.template cast<WaveT>().eval());
+			}
+			case SampleMethod::IFFT:
+				return this->samples_ifft(start, step, num_samples);
+			case SampleMethod::NUFFT:
+				return this->samples_nufft(start, step, num_samples);
+			case SampleMethod::Auto: {
+				// Rough cost of each kernel; the phasor bank is counted per multiply-add since it runs as a dense GEMV
+				CalcT phasor_cost = static_cast<CalcT>(this->num_waves()) * static_cast<CalcT>(num_samples);
+				std::optional<Eigen::Index> fft_size = this->fft_grid_size(step, num_samples);
+				if (fft_size.has_value()) {
+					CalcT fft_cost = 5 * static_cast<CalcT>(fft_size.value()) * std::log2(static_cast<CalcT>(fft_size.value()) + 1);
+					if (fft_cost < phasor_cost) {
+						return this->samples_ifft(start, step, num_samples, fft_size);
+					}
+				}
+				Eigen::Index spread_width, segment_size;
+				this->nufft_plan(num_samples, std::nullopt, spread_width, segment_size);
+				CalcT num_segments = std::ceil(static_cast<CalcT>(num_samples) / static_cast<CalcT>(segment_size));
+				CalcT nufft_cost = num_segments * (16 * static_cast<CalcT>(this->num_waves() * spread_width) + 10 * static_cast<CalcT>(segment_size) * std::log2(static_cast<CalcT>(2 * segment_size)));
+				if (nufft_cost < phasor_cost) {
+					return this->samples_nufft(start, step, num_samples);
+				}
+				return this->samples_phasor(start, step, num_samples);
+			}
+			default:
+				return this->samples_phasor(start, step, num_samples);
+			}
 		}
 
 		inline void to_csv_samples(const std::filesystem::path& filename, WaveT duration, std::optional<WaveT> sample_rate = std::nullopt, std::string timestamps_title = "Time", std::string samples_title = "Signal") const {
@@ -363,39 +933,143 @@ namespace Cyn {
 		// Fourier
 
 		static WaveArray<WaveT> from_samples(const Eigen::ArrayX<WaveT>& samples, std::optional<WaveT> sample_rate = std::nullopt, std::optional<WaveT> tolerance = std::nullopt, const size_t& num_threads = 1) {
-			Eigen::Index samples_size = samples.size();
-			Eigen::ArrayX<std::complex<WaveT>> ft = FFT::r2c(samples, false, num_threads);
+			// Any negative tolerance keeps every bin
+			return from_spectrum(FFT::r2c(samples, false, num_threads), samples.size(), sample_rate, tolerance.value_or(TOLERANCE), num_threads);
+		}
+
+		// One wave per bin of the r2c spectrum ft of samples_size samples. With a tolerance, bins whose amplitude is
+		// not above it are skipped, otherwise every bin is kept. Works column by column, and large spectra are split
+		// across num_threads threads.
+		static WaveArray<WaveT> from_spectrum(const Eigen::ArrayX<std::complex<WaveT>>& ft, Eigen::Index samples_size, std::optional<WaveT> sample_rate = std::nullopt, std::optional<WaveT> tolerance = std::nullopt, const size_t& num_threads = 1) {
+			constexpr Eigen::Index min_bins_per_thread = static_cast<Eigen::Index>(1) << 15;
 			Eigen::Index half_size = ft.size();
-			Eigen::Index conjugate_size = samples_size - half_size;
-			std::complex<WaveT> i(static_cast<WaveT>(0), static_cast<WaveT>(1));
-			std::complex<WaveT> cn;
-			std::complex<WaveT> cng;
-			WaveT an;
-			WaveT bn;
-			WaveT frequency;
-
-			Eigen::Index n2;
-			WaveArray<WaveT> result(samples_size, 3);
-			result.row(0) << static_cast<WaveT>(0), ft(0).real() / static_cast<WaveT>(samples_size), pi<WaveT>(1.5L);
-			for (Eigen::Index n = 1; n <= conjugate_size; ++n) {
-				n2 = n * 2;
-				cn = ft(n);
-				cng = std::conj(cn);
-				an = std::real(cn + cng) / static_cast<WaveT>(samples_size);
-				bn = std::real(i * (cn - cng)) / static_cast<WaveT>(samples_size);
-				frequency = (static_cast<WaveT>(n2) / static_cast<WaveT>(samples_size)) * nyquist_freq(sample_rate);
-				result.row(n2 - 1) << frequency, an, pi<WaveT>(1.5L);
-				result.row(n2) << frequency, bn, static_cast<WaveT>(0);
-			}
-			if (samples_size % 2 == 0) {
-				result.row(samples_size - 1) << nyquist_freq(sample_rate), ft(half_size - 1).real() / static_cast<WaveT>(samples_size), pi<WaveT>(1.5L);
-			}
+			if (half_size == 0) { return WaveArray<WaveT>(0, 3); }
+			bool has_nyquist = samples_size % 2 == 0;
+			WaveT inv_size = static_cast<WaveT>(1) / static_cast<WaveT>(samples_size);
+
+			// Each bin's cosine (an = 2 re / N) and sine (bn = -2 im / N) parts merge into one row:
+			// an*cos + bn*sin = amp*sin(x - phase) with amp = hypot(an, bn) and phase = atan2(-an, bn) = atan2(-re, -im).
+			// The constant and Nyquist rows keep their signed real part as amplitude with phase 3pi/2.
+			Eigen::ArrayX<WaveT> re = ft.real();
+			Eigen::ArrayX<WaveT> im = ft.imag();
+			Eigen::ArrayX<WaveT> amp = (re.square() + im.square()).sqrt() * (2 * inv_size);
+			amp(0) = re(0) * inv_size;
+			if (has_nyquist) { amp(half_size - 1) = re(half_size - 1) * inv_size; }
+
+			// Fused zero removal: only the kept bins are converted
+			Eigen::ArrayX<Eigen::Index> bins;
 			if (tolerance.has_value()) {
-				if (tolerance.value() < -0.5) {
-					return result;
+				Eigen::ArrayXb keep_mask = amp.abs() > tolerance.value();
+				bins.resize(keep_mask.count());
+				for (Eigen::Index n = 0, i = 0; n < half_size; ++n) {
+					if (keep_mask(n)) { bins(i++) = n; }
 				}
+				re = re(bins).eval();
+				im = im(bins).eval();
+				amp = amp(bins).eval();
+			}
+			else {
+				bins = Eigen::ArrayX<Eigen::Index>::LinSpaced(half_size, 0, half_size - 1);
+			}
+			Eigen::Index num_w = bins.size();
+			WaveArray<WaveT> result(num_w, 3);
+			if (num_w == 0) { return result; }
+			result.amp() = amp;
+
+			CalcT bin_width = static_cast<CalcT>(sample_rate.value_or(SAMPLE_RATE)) / static_cast<CalcT>(samples_size);
+			const WaveT two_pi = pi<WaveT>(2.0L);
+			auto convert = [&](Eigen::Index first, Eigen::Index count) {
+				result.freq().segment(first, count) = (bins.segment(first, count).template cast<CalcT>() * bin_width).template cast<WaveT>();
+				Eigen::ArrayX<WaveT> phase = (-re.segment(first, count)).binaryExpr(-im.segment(first, count), [](WaveT y, WaveT x) { return std::atan2(y, x); });
+				result.phase().segment(first, count) = (phase < 0).select(phase + two_pi, phase);
+			};
+			Eigen::Index num_workers = std::clamp(num_w / min_bins_per_thread, Eigen::Index(1), static_cast<Eigen::Index>(std::max<size_t>(num_threads, 1)));
+			if (num_workers == 1) {
+				convert(0, num_w);
+			}
+			else {
+				Eigen::Index chunk_size = (num_w + num_workers - 1) / num_workers;
+				std::vector<std::thread> workers;
+				for (Eigen::Index first = chunk_size; first < num_w; first += chunk_size) {
+					workers.emplace_back(convert, first, std::min(chunk_size, num_w - first));
+				}
+				convert(0, std::min(chunk_size, num_w));
+				for (std::thread& worker : workers) { worker.join(); }
+			}
+			if (bins(0) == 0) { result(0, 2) = pi<WaveT>(1.5L); }
+			if (has_nyquist && bins(num_w - 1) == half_size - 1) { result(num_w - 1, 2) = pi<WaveT>(1.5L); }
+			return result;
+		}
+
+		// Sparse form of from_samples: keeps the fewest, strongest bins whose dropped energy leaves a relative RMS
+		// error of at most target_error (0 keeps every nonzero bin), capped at max_waves. The DFT bins are orthogonal
+		// over the samples, so the error is exact and comes from Parseval's theorem without rendering.
+		static WaveArray<WaveT> from_samples_top(const Eigen::ArrayX<WaveT>& samples, std::optional<WaveT> sample_rate = std::nullopt, Eigen::Index max_waves = 256, WaveT target_error = static_cast<WaveT>(0), const size_t& num_threads = 1) {
+			WaveArray<WaveT> full = from_spectrum(FFT::r2c(samples, false, num_threads), samples.size(), sample_rate);
+			Eigen::Index num_w = full.num_waves();
+			// Energy over the samples is amp^2 / 2 per sinusoid and amp^2 for the constant and Nyquist rows
+			Eigen::ArrayX<CalcT> energy = full.amp().template cast<CalcT>().square() / 2;
+			energy(0) *= 2;
+			if (samples.size() % 2 == 0 && num_w > 1) { energy(num_w - 1) *= 2; }
+			CalcT max_residual = static_cast<CalcT>(target_error) * static_cast<CalcT>(target_error) * energy.sum();
+			std::vector<Eigen::Index> idx(num_w);
+			std::iota(idx.begin(), idx.end(), 0);
+			std::sort(idx.begin(), idx.end(), [&](Eigen::Index a, Eigen::Index b) { return energy(a) > energy(b); });
+			Eigen::ArrayXb keep_mask = Eigen::ArrayXb::Zero(num_w);
+			CalcT residual = energy.sum();
+			for (Eigen::Index i = 0; i < std::min(num_w, max_waves) && residual > max_residual && energy(idx[i]) > 0; ++i) {
+				keep_mask(idx[i]) = true;
+				residual -= energy(idx[i]);
 			}
-			return result.remove_zero(tolerance);
+			return full.filter(keep_mask);
+		}
+
+		// Sinusoidal model of samples from spectral peak picking: the samples are Hann windowed and zero padded by
+		// pad_factor, every local maximum of the magnitude spectrum of at least min_amplitude (default TOLERANCE) becomes
+		// one wave, and its frequency, amplitude and phase are refined by parabolic interpolation of the log magnitude
+		// around the peak. The max_waves strongest peaks are returned, sorted by frequency. Suited to recordings whose
+		// partials do not sit on the DFT bins; partials closer than about two bins merge into one peak.
+		static WaveArray<WaveT> from_samples_peaks(const Eigen::ArrayX<WaveT>& samples, std::optional<WaveT> sample_rate = std::nullopt, Eigen::Index max_waves = 256, std::optional<WaveT> min_amplitude = std::nullopt, Eigen::Index pad_factor = 2, const size_t& num_threads = 1) {
+			if (pad_factor < 1) { throw std::invalid_argument("pad_factor must be at least 1."); }
+			Eigen::Index samples_size = samples.size();
+			if (samples_size < 4 || max_waves < 1) { return WaveArray<WaveT>(0, 3); }
+			Eigen::Index fft_size = samples_size * pad_factor;
+			CalcT rate = static_cast<CalcT>(sample_rate.value_or(SAMPLE_RATE));
+			// Periodic Hann window sin^2(pi n / N), symmetric about n = N / 2
+			Eigen::ArrayX<CalcT> window = (Eigen::ArrayX<CalcT>::LinSpaced(samples_size, 0, static_cast<CalcT>(samples_size - 1)) / static_cast<CalcT>(samples_size) - static_cast<CalcT>(0.5L)).hann();
+			Eigen::ArrayX<CalcT> padded = Eigen::ArrayX<CalcT>::Zero(fft_size);
+			padded.head(samples_size) = samples.template cast<CalcT>() * window;
+			Eigen::ArrayX<std::complex<CalcT>> ft = FFT::r2c(padded, false, num_threads);
+			Eigen::ArrayX<CalcT> log_mag = (ft.abs() + std::numeric_limits<CalcT>::min()).log();
+			CalcT amp_scale = 2 / window.sum();
+			CalcT log_min_amp = std::log(static_cast<CalcT>(min_amplitude.value_or(TOLERANCE)) / amp_scale);
+			CalcT center = static_cast<CalcT>(samples_size) / 2;
+			const CalcT two_pi = pi<CalcT>(2.0L);
+
+			std::vector<Eigen::Index> peaks;
+			Eigen::Index num_bins = ft.size();
+			for (Eigen::Index k = 1; k + 1 < num_bins; ++k) {
+				if (log_mag(k) > log_mag(k - 1) && log_mag(k) >= log_mag(k + 1) && log_mag(k) >= log_min_amp) { peaks.push_back(k); }
+			}
+			if (static_cast<Eigen::Index>(peaks.size()) > max_waves) {
+				std::nth_element(peaks.begin(), peaks.begin() + max_waves, peaks.end(), [&](Eigen::Index a, Eigen::Index b) { return log_mag(a) > log_mag(b); });
+				peaks.resize(static_cast<size_t>(max_waves));
+			}
+			std::sort(peaks.begin(), peaks.end());
+
+			WaveArray<WaveT> result(static_cast<Eigen::Index>(peaks.size()), 3);
+			for (Eigen::Index i = 0; i < result.num_waves(); ++i) {
+				Eigen::Index k = peaks[i];
+				CalcT alpha = log_mag(k - 1), beta = log_mag(k), gamma = log_mag(k + 1);
+				CalcT denominator = alpha - 2 * beta + gamma;
+				CalcT offset = denominator < 0 ? static_cast<CalcT>(0.5L) * (alpha - gamma) / denominator : static_cast<CalcT>(0);
+				CalcT bin = static_cast<CalcT>(k) + offset;
+				CalcT amplitude = amp_scale * std::exp(beta - static_cast<CalcT>(0.25L) * (alpha - gamma) * offset);
+				// Bin k sits offset bins below the peak, which rotates its phase by 2 pi offset center / N
+				CalcT phase = -std::arg(ft(k)) - pi<CalcT>(0.5L) + two_pi * offset * center / static_cast<CalcT>(fft_size);
+				result.wave(i) << static_cast<WaveT>(bin * rate / static_cast<CalcT>(fft_size)), static_cast<WaveT>(amplitude), static_cast<WaveT>(posmod(phase, two_pi));
+			}
+			return result;
 		}
 
 		inline void shift_inplace(WaveT phase_shift) {
@@ -463,6 +1137,7 @@ namespace Cyn {
 		Eigen::Index num_w_lhs = lhs.num_waves();
 		lhs.conservativeResize(num_w_lhs + 1, Eigen::NoChange);
 		lhs.wave(num_w_lhs) << static_cast<WaveT>(0), static_cast<WaveT>(rhs), pi<WaveT>(1.5L);
+		lhs.auto_compact_inplace(num_w_lhs);
 		return lhs;
 	}
 
@@ -473,6 +1148,7 @@ namespace Cyn {
 		Eigen::Index num_w_rhs = rhs.num_waves();
 		lhs.conservativeResize(num_w_lhs + num_w_rhs, Eigen::NoChange);
 		lhs.waves(num_w_lhs, num_w_rhs) = rhs;
+		lhs.auto_compact_inplace(std::max(num_w_lhs, num_w_rhs));
 		return lhs;
 	}
 
@@ -503,6 +1179,7 @@ namespace Cyn {
 		Eigen::Index num_w_lhs = lhs.num_waves();
 		lhs.conservativeResize(num_w_lhs + 1, Eigen::NoChange);
 		lhs.wave(num_w_lhs) << static_cast<WaveT>(0), static_cast<WaveT>(-rhs), pi<WaveT>(1.5L);
+		lhs.auto_compact_inplace(num_w_lhs);
 		return lhs;
 	}
 
@@ -514,6 +1191,7 @@ namespace Cyn {
 		lhs.conservativeResize(num_w_lhs + num_w_rhs, Eigen::NoChange);
 		rhs.amp() *= -1;
 		lhs.waves(num_w_lhs, num_w_rhs) = rhs;
+		lhs.auto_compact_inplace(std::max(num_w_lhs, num_w_rhs));
 		return lhs;
 	}
 
@@ -539,20 +1217,42 @@ namespace Cyn {
 		return lhs;
 	}
 
+	// WaveArray Multiplication Into
+	// Writes the sum sidebands to the first half of dst and the difference sidebands to the second half,
+	// lhs varying fastest. dst keeps its allocation when it already holds 2 * lhs.num_waves() * rhs.num_waves() waves.
+	template<NumF WaveT>
+	void multiply_into(WaveArray<WaveT>& dst, const WaveArray<WaveT>& lhs, const WaveArray<WaveT>& rhs) {
+		if (&dst == &lhs || &dst == &rhs) {
+			WaveArray<WaveT> result;
+			multiply_into(result, lhs, rhs);
+			dst = std::move(result);
+			return;
+		}
+		Eigen::Index num_w_lhs = lhs.num_waves();
+		Eigen::Index num_w_rhs = rhs.num_waves();
+		Eigen::Index half_num_waves = num_w_lhs * num_w_rhs;
+		dst.resize(2 * half_num_waves, 3);
+		for (Eigen::Index j = 0; j < num_w_rhs; ++j) {
+			Eigen::Index sum_start = j * num_w_lhs;
+			Eigen::Index diff_start = half_num_waves + sum_start;
+			WaveT rhs_freq = rhs(j, 0);
+			WaveT rhs_amp = static_cast<WaveT>(0.5L) * rhs(j, 1);
+			WaveT rhs_phase = rhs(j, 2) + pi<WaveT>(0.5L);
+			dst.freq().segment(sum_start, num_w_lhs) = lhs.freq() + rhs_freq;
+			dst.freq().segment(diff_start, num_w_lhs) = lhs.freq() - rhs_freq;
+			dst.amp().segment(sum_start, num_w_lhs) = lhs.amp() * rhs_amp;
+			dst.amp().segment(diff_start, num_w_lhs) = lhs.amp() * rhs_amp;
+			dst.phase().segment(sum_start, num_w_lhs) = lhs.phase() + rhs_phase;
+			dst.phase().segment(diff_start, num_w_lhs) = lhs.phase() - rhs_phase;
+		}
+	}
+
 	// WaveArray Multiplication
 	template<NumF WaveT>
 	WaveArray<WaveT> operator*(const WaveArray<WaveT>& lhs, const WaveArray<WaveT>& rhs) {
-		Eigen::Array<WaveT, Eigen::Dynamic, Eigen::Dynamic> freq_lhs, freq_rhs, phase_lhs, phase_rhs;
-		cartesian_product(lhs.freq(), rhs.freq(), freq_lhs, freq_rhs);
-		cartesian_product(lhs.phase(), rhs.phase() + pi<WaveT>(0.5L), phase_lhs, phase_rhs);
-		Eigen::Index half_num_waves = lhs.num_waves() * rhs.num_waves();
-		WaveArray<WaveT> result(2 * half_num_waves, 3);
-		result.block(0, 0, half_num_waves, 1) = (freq_lhs + freq_rhs).reshaped();
-		result.block(0, 1, half_num_waves, 1) = (0.5 * lhs.amp().matrix() * rhs.amp().matrix().transpose()).reshaped();
-		result.block(0, 2, half_num_waves, 1) = (phase_lhs + phase_rhs).reshaped();
-		result.block(half_num_waves, 0, half_num_waves, 1) = (freq_lhs - freq_rhs).reshaped();
-		result.block(half_num_waves, 1, half_num_waves, 1) = result.block(0, 1, half_num_waves, 1);
-		result.block(half_num_waves, 2, half_num_waves, 1) = (phase_lhs - phase_rhs).reshaped();
+		WaveArray<WaveT> result;
+		multiply_into(result, lhs, rhs);
+		result.auto_compact_inplace(std::max(lhs.num_waves(), rhs.num_waves()));
 		return result;
 	}
 
@@ -600,9 +1300,8 @@ namespace Cyn {
 
 	// NumI Power
 	template<NumF WaveT, NumI T>
-	WaveArray<WaveT> operator^(WaveArray<WaveT> lhs, T rhs) {
-		throw std::runtime_error("Not Implemented.");
-		return WaveArray<WaveT>{0.0f, 0.0f, 0.0f};
+	inline WaveArray<WaveT> operator^(const WaveArray<WaveT>& lhs, T rhs) {
+		return lhs.pow(static_cast<Eigen::Index>(rhs));
 	}
 
 	// NumI Power Assignment
@@ -0,0 +1,192 @@
+/*
+ * Except where otherwise noted, Cynthasine  2024 by https://github.com/h2see is licensed under Creative
+ * Commons Attribution-NonCommercial-ShareAlike 4.0 International. To view a
+ * copy of this license, visit https://creativecommons.org/licenses/by-nc-sa/4.0/
+ */
+
+#ifndef CYN_WAVE_ANALYZER_HPP
+#define CYN_WAVE_ANALYZER_HPP
+
+#include "CynWaveSequence.hpp"
+
+#include <deque>
+
+namespace Cyn {
+
+	// Short-time Fourier analysis of a sample stream into one compact WaveArray per frame.
+	// Samples can be pushed in blocks of any size. Every hop_size samples, the last window_size samples are Hann
+	// windowed, zero padded to fft_size and converted with WaveArray::from_spectrum. Bins at or below tolerance are
+	// dropped (a negative tolerance keeps them all), and with max_waves only the strongest bins are kept. Each frame's waves are shifted to the frame's
+	// absolute start time and scaled so that overlap-adding the frames (see to_sequence) gives back the input,
+	// which holds exactly for hops of window_size / k, k >= 2. Only one window of samples is buffered, so memory
+	// stays bounded however long the recording is.
+	template<NumF WaveT>
+	class WaveAnalyzer {
+	public:
+
+		using CalcT = typename WaveArray<WaveT>::CalcT;
+
+		struct Frame {
+			WaveArray<WaveT> waves;
+			CalcT start; // Frame bounds in seconds, the first frames start before 0 so the input's head is fully covered
+			CalcT stop;
+		};
+
+		// Constructors
+
+		WaveAnalyzer(Eigen::Index window_size = 2048, Eigen::Index hop_size = 512, std::optional<Eigen::Index> fft_size = std::nullopt, std::optional<WaveT> sample_rate = std::nullopt, std::optional<WaveT> tolerance = std::nullopt, Eigen::Index max_waves = 0)
+			: analyzer_window_size(window_size), analyzer_hop_size(hop_size), analyzer_fft_size(fft_size.value_or(window_size)), analyzer_sample_rate(sample_rate.value_or(WaveArray<WaveT>::SAMPLE_RATE)), analyzer_tolerance(tolerance), analyzer_max_waves(max_waves) {
+			if (analyzer_window_size < 2) { throw std::invalid_argument("window_size must be at least 2."); }
+			if (analyzer_hop_size < 1 || analyzer_hop_size > analyzer_window_size) { throw std::invalid_argument("hop_size must be in [1, window_size]."); }
+			if (analyzer_fft_size < analyzer_window_size) { throw std::invalid_argument("fft_size must be at least window_size."); }
+			if (!(analyzer_sample_rate > 0)) { throw std::invalid_argument("sample_rate must be positive."); }
+			if (analyzer_max_waves < 0) { throw std::invalid_argument("max_waves must be non-negative."); }
+			// Periodic Hann window, sin^2(pi k / N), through the hann() addon over [-1/2, 1/2)
+			window = (Eigen::ArrayX<CalcT>::LinSpaced(analyzer_window_size, 0, static_cast<CalcT>(analyzer_window_size - 1)) / static_cast<CalcT>(analyzer_window_size) - static_cast<CalcT>(0.5L)).hann().template cast<WaveT>();
+			overlap_gain = window.template cast<CalcT>().sum() / static_cast<CalcT>(analyzer_hop_size);
+			frame = Eigen::ArrayX<WaveT>::Zero(analyzer_fft_size);
+			this->reset();
+		}
+
+		// Accessors
+
+		inline Eigen::Index window_size() const {
+			return analyzer_window_size;
+		}
+		inline Eigen::Index hop_size() const {
+			return analyzer_hop_size;
+		}
+		inline Eigen::Index fft_size() const {
+			return analyzer_fft_size;
+		}
+		inline WaveT sample_rate() const {
+			return analyzer_sample_rate;
+		}
+		// Number of input samples pushed since the last reset
+		inline Eigen::Index num_samples() const {
+			return num_pushed;
+		}
+		inline Eigen::Index num_frames_ready() const {
+			return static_cast<Eigen::Index>(ready.size());
+		}
+
+		// Analysis
+
+		// Appends samples to the stream and analyzes every frame they complete
+		template <typename Derived>
+		void push(const Eigen::ArrayBase<Derived>& samples) {
+			if (flushed) { throw std::logic_error("WaveAnalyzer was flushed, reset() it before pushing more samples."); }
+			Eigen::Index num_new = samples.size();
+			size_t old_size = buffer.size();
+			buffer.resize(old_size + static_cast<size_t>(num_new));
+			Eigen::Map<Eigen::ArrayX<WaveT>>(buffer.data() + old_size, num_new) = samples.template cast<WaveT>();
+			num_pushed += num_new;
+			size_t frame_start = 0;
+			while (buffer.size() - frame_start >= static_cast<size_t>(analyzer_window_size)) {
+				this->analyze(buffer.data() + frame_start, analyzer_window_size);
+				frame_start += static_cast<size_t>(analyzer_hop_size);
+			}
+			buffer.erase(buffer.begin(), buffer.begin() + static_cast<std::ptrdiff_t>(frame_start));
+		}
+
+		// Analyzes the remaining frames that overlap the pushed samples, treating the stream as zero past its end
+		void flush() {
+			if (flushed) { return; }
+			size_t frame_start = 0;
+			while (buffer_position < num_pushed) {
+				Eigen::Index num_available = std::min(static_cast<Eigen::Index>(buffer.size() - frame_start), analyzer_window_size);
+				this->analyze(buffer.data() + frame_start, num_available);
+				frame_start = std::min(frame_start + static_cast<size_t>(analyzer_hop_size), buffer.size());
+			}
+			buffer.clear();
+			flushed = true;
+		}
+
+		// Pops the oldest analyzed frame into result, returns false if none is ready
+		bool next(Frame& result) {
+			if (ready.empty()) { return false; }
+			result = std::move(ready.front());
+			ready.pop_front();
+			return true;
+		}
+
+		void reset() {
+			// Start window_size - hop_size samples early so the input's first samples get their full overlap
+			buffer.assign(static_cast<size_t>(analyzer_window_size - analyzer_hop_size), static_cast<WaveT>(0));
+			buffer_position = -(analyzer_window_size - analyzer_hop_size);
+			num_pushed = 0;
+			ready.clear();
+			flushed = false;
+		}
+
+		// Moves every ready frame into a WaveSequence, one segment per frame
+		WaveSequence<WaveT> to_sequence() {
+			WaveSequence<WaveT> result;
+			Frame next_frame;
+			while (this->next(next_frame)) {
+				result.add(std::move(next_frame.waves), static_cast<WaveT>(next_frame.start), static_cast<WaveT>(next_frame.stop));
+			}
+			return result;
+		}
+
+		// Analyzes a whole recording
+		template <typename Derived>
+		static WaveSequence<WaveT> analyze(const Eigen::ArrayBase<Derived>& samples, Eigen::Index window_size = 2048, Eigen::Index hop_size = 512, std::optional<Eigen::Index> fft_size = std::nullopt, std::optional<WaveT> sample_rate = std::nullopt, std::optional<WaveT> tolerance = std::nullopt, Eigen::Index max_waves = 0) {
+			WaveAnalyzer<WaveT> analyzer(window_size, hop_size, fft_size, sample_rate, tolerance, max_waves);
+			analyzer.push(samples);
+			analyzer.flush();
+			return analyzer.to_sequence();
+		}
+
+	private:
+
+		// Analyzes the frame starting at buffer_position from its first num_available samples (zero past them)
+		// and advances buffer_position by one hop
+		void analyze(const WaveT* samples, Eigen::Index num_available) {
+			frame.head(num_available) = Eigen::Map<const Eigen::ArrayX<WaveT>>(samples, num_available) * window.head(num_available);
+			frame.segment(num_available, analyzer_window_size - num_available).setZero();
+			FFT::default_context().r2c(frame, spectrum);
+			WaveArray<WaveT> waves = WaveArray<WaveT>::from_spectrum(spectrum, analyzer_fft_size, analyzer_sample_rate);
+			waves.amp() /= static_cast<WaveT>(overlap_gain);
+			waves = waves.remove_zero(analyzer_tolerance);
+			if (analyzer_max_waves > 0 && waves.num_waves() > analyzer_max_waves) {
+				Eigen::ArrayX<WaveT> amps = waves.amp().abs();
+				std::nth_element(amps.begin(), amps.begin() + (analyzer_max_waves - 1), amps.end(), std::greater<WaveT>());
+				waves = waves.filter(waves.amp().abs() >= amps(analyzer_max_waves - 1));
+				waves.conservativeResize(std::min(waves.num_waves(), analyzer_max_waves), Eigen::NoChange);
+			}
+			CalcT start = static_cast<CalcT>(buffer_position) / static_cast<CalcT>(analyzer_sample_rate);
+			// Each wave's phase offset is reduced to a fraction of a cycle in CalcT before narrowing to WaveT,
+			// so frames late into a long recording keep their phases
+			Eigen::ArrayX<CalcT> cycles = waves.freq().template cast<CalcT>() * start;
+			cycles -= cycles.floor();
+			waves.phase() += (cycles * pi<CalcT>(2.0L)).template cast<WaveT>();
+			CalcT stop = static_cast<CalcT>(buffer_position + analyzer_window_size) / static_cast<CalcT>(analyzer_sample_rate);
+			ready.push_back(Frame{ std::move(waves), start, stop });
+			buffer_position += analyzer_hop_size;
+		}
+
+		Eigen::Index analyzer_window_size;
+		Eigen::Index analyzer_hop_size;
+		Eigen::Index analyzer_fft_size;
+		WaveT analyzer_sample_rate;
+		std::optional<WaveT> analyzer_tolerance;
+		Eigen::Index analyzer_max_waves;
+		Eigen::ArrayX<WaveT> window;
+		CalcT overlap_gain;
+		Eigen::ArrayX<WaveT> frame;                    // Zero padded to fft_size, padding stays zero
+		Eigen::ArrayX<std::complex<WaveT>> spectrum;
+		std::vector<WaveT> buffer;                    // Unanalyzed samples, buffer[0] is sample buffer_position
+		Eigen::Index buffer_position = 0;
+		Eigen::Index num_pushed = 0;
+		std::deque<Frame> ready;
+		bool flushed = false;
+	};
+
+	using WaveAnalyzerF = WaveAnalyzer<float>;
+	using WaveAnalyzerD = WaveAnalyzer<double>;
+	using WaveAnalyzerL = WaveAnalyzer<long double>;
+
+} // namespace Cyn
+
+#endif // CYN_WAVE_ANALYZER_HPP
\ No newline at end of file
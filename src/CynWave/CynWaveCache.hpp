@@ -0,0 +1,162 @@
+/*
+ * Except where otherwise noted, Cynthasine  2024 by https://github.com/h2see is licensed under Creative
+ * Commons Attribution-NonCommercial-ShareAlike 4.0 International. To view a
+ * copy of this license, visit https://creativecommons.org/licenses/by-nc-sa/4.0/
+ */
+
+#ifndef CYN_WAVE_CACHE_HPP
+#define CYN_WAVE_CACHE_HPP
+
+#include "CynEigenUtils.h"
+
+#include <array>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Cyn {
+
+	template<NumF WaveT>
+	struct RenderCachePolicy {
+		bool enabled = false;
+		size_t max_bytes = static_cast<size_t>(64) << 20; // Least recently used renders are evicted past this many bytes of samples
+		std::optional<WaveT> tolerance = std::nullopt;     // Waves whose parameters round to the same multiples of it share renders, exact match when unset
+	};
+
+	struct RenderCacheStats {
+		size_t hits = 0;
+		size_t misses = 0;
+		size_t evictions = 0;
+		size_t entries = 0;
+		size_t bytes = 0;
+
+		inline double hit_rate() const { return hits + misses == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(hits + misses); }
+	};
+
+	// Mixes value into seed (boost::hash_combine with a 64 bit golden ratio constant)
+	inline size_t hash_combine(size_t seed, size_t value) {
+		return seed ^ (value + static_cast<size_t>(0x9e3779b97f4a7c15ULL) + (seed << 6) + (seed >> 2));
+	}
+
+	// Order independent hash of sorted wave parameter rows
+	template<NumF WaveT>
+	size_t hash_content_rows(const std::vector<std::array<WaveT, 3>>& rows) {
+		size_t seed = std::hash<size_t>{}(rows.size());
+		for (const std::array<WaveT, 3>& row : rows) {
+			for (WaveT value : row) { seed = hash_combine(seed, std::hash<WaveT>{}(value)); }
+		}
+		return seed;
+	}
+
+	// Everything a render depends on. The cache compares it on lookup, so renders whose hashes collide are never mixed up.
+	template<NumF WaveT>
+	struct RenderKey {
+		std::vector<std::array<WaveT, 3>> rows; // Sorted, optionally quantized wave parameters, see WaveArray::content_rows()
+		WaveT duration = 0;
+		WaveT sample_rate = 0;
+		size_t method = 0;
+		Eigen::Index num_samples = 0;
+		WaveT tolerance = 0;          // WaveArray::TOLERANCE, used by period and FFT grid detection
+		bool periodic_tiling = false; // WaveArray::PERIODIC_TILING
+
+		bool operator==(const RenderKey&) const = default;
+
+		size_t hash() const {
+			size_t seed = hash_content_rows(rows);
+			seed = hash_combine(seed, std::hash<WaveT>{}(duration));
+			seed = hash_combine(seed, std::hash<WaveT>{}(sample_rate));
+			seed = hash_combine(seed, method);
+			seed = hash_combine(seed, static_cast<size_t>(num_samples));
+			seed = hash_combine(seed, std::hash<WaveT>{}(tolerance));
+			return hash_combine(seed, static_cast<size_t>(periodic_tiling));
+		}
+	};
+
+	// Least recently used store of rendered samples indexed by the hash of their RenderKey. Safe to share across threads,
+	// stats are only updated under the cache's lock.
+	template<NumF WaveT>
+	class RenderCache {
+	public:
+
+		// Copies the samples cached under key into result and marks them most recently used. A render whose key only
+		// shares the hash counts as a miss.
+		bool find(const RenderKey<WaveT>& key, Eigen::ArrayX<WaveT>& result, RenderCacheStats& stats) {
+			std::lock_guard<std::mutex> lock(cache_mutex);
+			auto it = index.find(key.hash());
+			if (it == index.end() || !(it->second->key == key)) {
+				++stats.misses;
+				return false;
+			}
+			entries.splice(entries.begin(), entries, it->second);
+			result = it->second->samples;
+			++stats.hits;
+			return true;
+		}
+
+		// Caches a copy of samples under key, replacing any render with the same hash, then evicts the least recently
+		// used renders until max_bytes is met. Renders larger than max_bytes on their own are not cached.
+		void insert(const RenderKey<WaveT>& key, const Eigen::ArrayX<WaveT>& samples, size_t max_bytes, RenderCacheStats& stats) {
+			size_t num_bytes = bytes_of(samples);
+			if (num_bytes > max_bytes) { return; }
+			size_t hash = key.hash();
+			std::lock_guard<std::mutex> lock(cache_mutex);
+			auto it = index.find(hash);
+			if (it != index.end()) {
+				num_bytes_cached -= bytes_of(it->second->samples);
+				entries.erase(it->second);
+				index.erase(it);
+			}
+			entries.push_front(Entry{ hash, key, samples });
+			index.emplace(hash, entries.begin());
+			num_bytes_cached += num_bytes;
+			evict(max_bytes, stats);
+		}
+
+		// Evicts the least recently used renders until at most max_bytes remain
+		void shrink(size_t max_bytes, RenderCacheStats& stats) {
+			std::lock_guard<std::mutex> lock(cache_mutex);
+			evict(max_bytes, stats);
+		}
+
+		void clear(RenderCacheStats& stats) {
+			std::lock_guard<std::mutex> lock(cache_mutex);
+			entries.clear();
+			index.clear();
+			num_bytes_cached = 0;
+			stats.entries = 0;
+			stats.bytes = 0;
+		}
+
+	private:
+
+		struct Entry {
+			size_t hash;
+			RenderKey<WaveT> key;
+			Eigen::ArrayX<WaveT> samples;
+		};
+
+		static size_t bytes_of(const Eigen::ArrayX<WaveT>& samples) { return static_cast<size_t>(samples.size()) * sizeof(WaveT); }
+
+		// Expects cache_mutex held
+		void evict(size_t max_bytes, RenderCacheStats& stats) {
+			while (num_bytes_cached > max_bytes && !entries.empty()) {
+				num_bytes_cached -= bytes_of(entries.back().samples);
+				index.erase(entries.back().hash);
+				entries.pop_back();
+				++stats.evictions;
+			}
+			stats.entries = entries.size();
+			stats.bytes = num_bytes_cached;
+		}
+
+		std::mutex cache_mutex;
+		std::list<Entry> entries; // Most recently used first
+		std::unordered_map<size_t, typename std::list<Entry>::iterator> index;
+		size_t num_bytes_cached = 0;
+	};
+
+} // namespace Cyn
+
+#endif // CYN_WAVE_CACHE_HPP
\ No newline at end of file
@@ -0,0 +1,300 @@
+/*
+ * Except where otherwise noted, Cynthasine  2024 by https://github.com/h2see is licensed under Creative
+ * Commons Attribution-NonCommercial-ShareAlike 4.0 International. To view a
+ * copy of this license, visit https://creativecommons.org/licenses/by-nc-sa/4.0/
+ */
+
+#ifndef CYN_WAVE_EXPR_HPP
+#define CYN_WAVE_EXPR_HPP
+
+#include "CynWave.hpp"
+
+namespace Cyn {
+
+	// Unevaluated sum of products of WaveArrays.
+	// Sampling renders every factor on its own and multiplies the renders pointwise, so a product of N and M waves
+	// costs N + M partials instead of the 2 N M rows operator* would materialize. eval() (and to_csv, standardize)
+	// still produce the spectral form when it is actually needed.
+	template<NumF WaveT>
+	class WaveExpr {
+	public:
+
+		struct Term {
+			WaveT coeff;
+			std::vector<WaveArray<WaveT>> factors;
+		};
+
+		// Constructors
+
+		WaveExpr() = default;
+
+		WaveExpr(const WaveArray<WaveT>& wave) : expr_terms{ Term{ static_cast<WaveT>(1), { wave } } } {}
+
+		WaveExpr(WaveArray<WaveT>&& wave) {
+			expr_terms.push_back(Term{ static_cast<WaveT>(1), {} });
+			expr_terms.back().factors.push_back(std::move(wave));
+		}
+
+		template<NumA T>
+		explicit WaveExpr(T constant) : expr_terms{ Term{ static_cast<WaveT>(constant), {} } } {}
+
+		// Accessors
+
+		inline const std::vector<Term>& terms() const {
+			return expr_terms;
+		}
+		inline Eigen::Index num_terms() const {
+			return static_cast<Eigen::Index>(expr_terms.size());
+		}
+
+		// Partials rendered per sample when sampling lazily
+		Eigen::Index num_waves() const {
+			Eigen::Index result = 0;
+			for (const Term& term : expr_terms) {
+				for (const WaveArray<WaveT>& factor : term.factors) {
+					result += factor.num_waves();
+				}
+			}
+			return result;
+		}
+
+		// Rows of the materialized WaveArray, each product of k factors has 2^(k - 1) times the product of their rows
+		Eigen::Index eval_num_waves() const {
+			Eigen::Index result = 0;
+			for (const Term& term : expr_terms) {
+				Eigen::Index term_num_w = 1;
+				for (size_t i = 0; i < term.factors.size(); ++i) {
+					term_num_w *= term.factors[i].num_waves() * (i > 0 ? 2 : 1);
+				}
+				result += term_num_w;
+			}
+			return result;
+		}
+
+		// Evaluation
+
+		WaveArray<WaveT> eval() const {
+			WaveArray<WaveT> result(0, 3);
+			for (const Term& term : expr_terms) {
+				if (term.factors.empty()) {
+					result += term.coeff;
+					continue;
+				}
+				WaveArray<WaveT> product = term.factors[0];
+				for (size_t i = 1; i < term.factors.size(); ++i) {
+					product = product * term.factors[i];
+				}
+				product.amp() *= term.coeff;
+				result += product;
+			}
+			return result;
+		}
+
+		inline void to_csv(const std::filesystem::path& filename) const {
+			this->eval().to_csv(filename);
+		}
+
+		inline WaveArray<WaveT> standardize(std::optional<WaveT> tolerance = std::nullopt) const {
+			return this->eval().standardize(tolerance);
+		}
+
+		// Sampling
+
+		Eigen::ArrayX<WaveT> samples(const Eigen::ArrayX<WaveT>& timestamps) const {
+			return this->render([&](const WaveArray<WaveT>& factor) { return factor.samples(timestamps); }, timestamps.size());
+		}
+
+		Eigen::ArrayX<WaveT> samples(WaveT duration, std::optional<WaveT> sample_rate = std::nullopt, Eigen::ArrayX<WaveT>* generated_timestamps = nullptr, std::optional<SampleMethod> method = std::nullopt) const {
+			if (generated_timestamps != nullptr) { *generated_timestamps = WaveArray<WaveT>::generate_timestamps(duration, sample_rate); }
+			return this->render([&](const WaveArray<WaveT>& factor) { return factor.samples(duration, sample_rate, nullptr, method); }, WaveArray<WaveT>::num_timestamps(duration, sample_rate));
+		}
+
+		inline void to_csv_samples(const std::filesystem::path& filename, WaveT duration, WaveT sample_rate, std::string timestamps_title = "Time", std::string samples_title = "Signal") const {
+			Eigen::ArrayX<WaveT> time;
+			Eigen::ArrayX<WaveT> signal = this->samples(duration, sample_rate, &time);
+			save_to_csv(filename, time, signal, timestamps_title, samples_title);
+		}
+
+		// Arithmetic
+
+		WaveExpr<WaveT>& operator+=(const WaveExpr<WaveT>& rhs) {
+			expr_terms.insert(expr_terms.end(), rhs.expr_terms.begin(), rhs.expr_terms.end());
+			return *this;
+		}
+
+		WaveExpr<WaveT>& operator-=(const WaveExpr<WaveT>& rhs) {
+			for (const Term& term : rhs.expr_terms) {
+				expr_terms.push_back(Term{ -term.coeff, term.factors });
+			}
+			return *this;
+		}
+
+		WaveExpr<WaveT>& operator*=(const WaveExpr<WaveT>& rhs) {
+			std::vector<Term> product_terms;
+			product_terms.reserve(expr_terms.size() * rhs.expr_terms.size());
+			for (const Term& lhs_term : expr_terms) {
+				for (const Term& rhs_term : rhs.expr_terms) {
+					Term term{ lhs_term.coeff * rhs_term.coeff, lhs_term.factors };
+					term.factors.insert(term.factors.end(), rhs_term.factors.begin(), rhs_term.factors.end());
+					product_terms.push_back(std::move(term));
+				}
+			}
+			expr_terms = std::move(product_terms);
+			return *this;
+		}
+
+		template<NumA T>
+		WaveExpr<WaveT>& operator*=(T rhs) {
+			for (Term& term : expr_terms) {
+				term.coeff *= static_cast<WaveT>(rhs);
+			}
+			return *this;
+		}
+
+		template<NumA T>
+		WaveExpr<WaveT>& operator/=(T rhs) {
+			for (Term& term : expr_terms) {
+				term.coeff /= static_cast<WaveT>(rhs);
+			}
+			return *this;
+		}
+
+	private:
+		std::vector<Term> expr_terms;
+
+		template<typename RenderFactor>
+		Eigen::ArrayX<WaveT> render(RenderFactor render_factor, Eigen::Index num_samples) const {
+			Eigen::ArrayX<WaveT> result = Eigen::ArrayX<WaveT>::Zero(num_samples);
+			Eigen::ArrayX<WaveT> product;
+			for (const Term& term : expr_terms) {
+				if (term.factors.empty()) {
+					result += term.coeff;
+					continue;
+				}
+				product = render_factor(term.factors[0]);
+				for (size_t i = 1; i < term.factors.size(); ++i) {
+					product *= render_factor(term.factors[i]);
+				}
+				result += product * term.coeff;
+			}
+			return result;
+		}
+
+	}; // class WaveExpr
+
+	// ========================================================================
+	// Operations
+
+	// Negation
+	template<NumF WaveT>
+	inline WaveExpr<WaveT> operator-(WaveExpr<WaveT> rhs) {
+		rhs *= -1;
+		return rhs;
+	}
+
+	// WaveExpr Addition
+	template<NumF WaveT>
+	inline WaveExpr<WaveT> operator+(WaveExpr<WaveT> lhs, const WaveExpr<WaveT>& rhs) {
+		lhs += rhs;
+		return lhs;
+	}
+	template<NumF WaveT>
+	inline WaveExpr<WaveT> operator+(WaveExpr<WaveT> lhs, const WaveArray<WaveT>& rhs) {
+		lhs += WaveExpr<WaveT>(rhs);
+		return lhs;
+	}
+	template<NumF WaveT>
+	inline WaveExpr<WaveT> operator+(const WaveArray<WaveT>& lhs, const WaveExpr<WaveT>& rhs) {
+		WaveExpr<WaveT> result(lhs);
+		result += rhs;
+		return result;
+	}
+	template<NumF WaveT, NumA T>
+	inline WaveExpr<WaveT> operator+(WaveExpr<WaveT> lhs, T rhs) {
+		lhs += WaveExpr<WaveT>(rhs);
+		return lhs;
+	}
+	template<NumF WaveT, NumA T>
+	inline WaveExpr<WaveT> operator+(T lhs, WaveExpr<WaveT> rhs) {
+		rhs += WaveExpr<WaveT>(lhs);
+		return rhs;
+	}
+
+	// WaveExpr Subtraction
+	template<NumF WaveT>
+	inline WaveExpr<WaveT> operator-(WaveExpr<WaveT> lhs, const WaveExpr<WaveT>& rhs) {
+		lhs -= rhs;
+		return lhs;
+	}
+	template<NumF WaveT>
+	inline WaveExpr<WaveT> operator-(WaveExpr<WaveT> lhs, const WaveArray<WaveT>& rhs) {
+		lhs -= WaveExpr<WaveT>(rhs);
+		return lhs;
+	}
+	template<NumF WaveT>
+	inline WaveExpr<WaveT> operator-(const WaveArray<WaveT>& lhs, const WaveExpr<WaveT>& rhs) {
+		WaveExpr<WaveT> result(lhs);
+		result -= rhs;
+		return result;
+	}
+	template<NumF WaveT, NumA T>
+	inline WaveExpr<WaveT> operator-(WaveExpr<WaveT> lhs, T rhs) {
+		lhs += WaveExpr<WaveT>(-static_cast<WaveT>(rhs));
+		return lhs;
+	}
+	template<NumF WaveT, NumA T>
+	inline WaveExpr<WaveT> operator-(T lhs, WaveExpr<WaveT> rhs) {
+		rhs *= -1;
+		rhs += WaveExpr<WaveT>(lhs);
+		return rhs;
+	}
+
+	// WaveExpr Multiplication
+	template<NumF WaveT>
+	inline WaveExpr<WaveT> operator*(WaveExpr<WaveT> lhs, const WaveExpr<WaveT>& rhs) {
+		lhs *= rhs;
+		return lhs;
+	}
+	template<NumF WaveT>
+	inline WaveExpr<WaveT> operator*(WaveExpr<WaveT> lhs, const WaveArray<WaveT>& rhs) {
+		lhs *= WaveExpr<WaveT>(rhs);
+		return lhs;
+	}
+	template<NumF WaveT>
+	inline WaveExpr<WaveT> operator*(const WaveArray<WaveT>& lhs, const WaveExpr<WaveT>& rhs) {
+		WaveExpr<WaveT> result(lhs);
+		result *= rhs;
+		return result;
+	}
+	template<NumF WaveT, NumA T>
+	inline WaveExpr<WaveT> operator*(WaveExpr<WaveT> lhs, T rhs) {
+		lhs *= rhs;
+		return lhs;
+	}
+	template<NumF WaveT, NumA T>
+	inline WaveExpr<WaveT> operator*(T lhs, WaveExpr<WaveT> rhs) {
+		rhs *= lhs;
+		return rhs;
+	}
+
+	// NumA Division
+	template<NumF WaveT, NumA T>
+	inline WaveExpr<WaveT> operator/(WaveExpr<WaveT> lhs, T rhs) {
+		lhs /= rhs;
+		return lhs;
+	}
+
+	// Lazy Construction
+	template<NumF WaveT>
+	inline WaveExpr<WaveT> lazy(const WaveArray<WaveT>& wave) {
+		return WaveExpr<WaveT>(wave);
+	}
+
+	using LazyWave = WaveExpr<float>;
+	using LazyWaveF = WaveExpr<float>;
+	using LazyWaveD = WaveExpr<double>;
+	using LazyWaveL = WaveExpr<long double>;
+
+} // namespace Cyn
+
+#endif // CYN_WAVE_EXPR_HPP
\ No newline at end of file
@@ -0,0 +1,155 @@
+/*
+ * Except where otherwise noted, Cynthasine  2024 by https://github.com/h2see is licensed under Creative
+ * Commons Attribution-NonCommercial-ShareAlike 4.0 International. To view a
+ * copy of this license, visit https://creativecommons.org/licenses/by-nc-sa/4.0/
+ */
+
+#ifndef CYN_WAVE_SEQUENCE_HPP
+#define CYN_WAVE_SEQUENCE_HPP
+
+#include "CynWave.hpp"
+
+namespace Cyn {
+
+	// WaveArrays that only sound inside their own time window [start, stop), optionally faded in and out.
+	// Sequencing costs nothing spectrally (unlike join(), which multiplies by a pulse train), and sampling
+	// renders each segment over its active samples only, so a sequence of thousands of notes stays cheap.
+	template<NumF WaveT>
+	class WaveSequence {
+	public:
+
+		using CalcT = typename WaveArray<WaveT>::CalcT;
+
+		struct Segment {
+			WaveArray<WaveT> waves;
+			WaveT start;
+			WaveT stop;
+			WaveT fade; // Raised cosine fade in and out, in seconds, capped at half the segment
+		};
+
+		// Constructors
+
+		WaveSequence() = default;
+
+		// Segments
+
+		void add(WaveArray<WaveT> waves, WaveT start, WaveT stop, WaveT fade = static_cast<WaveT>(0)) {
+			if (stop < start) { throw std::invalid_argument("Segment stop must not precede its start."); }
+			if (fade < 0) { throw std::invalid_argument("Segment fade must be non-negative."); }
+			seq_segments.push_back(Segment{ std::move(waves), start, stop, fade });
+		}
+
+		// Adds a segment starting gap seconds after the current end of the sequence
+		inline void append(WaveArray<WaveT> waves, WaveT duration, WaveT fade = static_cast<WaveT>(0), WaveT gap = static_cast<WaveT>(0)) {
+			WaveT start = this->duration() + gap;
+			this->add(std::move(waves), start, start + duration, fade);
+		}
+
+		inline void clear() {
+			seq_segments.clear();
+		}
+
+		// Accessors
+
+		inline const std::vector<Segment>& segments() const {
+			return seq_segments;
+		}
+		inline Eigen::Index num_segments() const {
+			return static_cast<Eigen::Index>(seq_segments.size());
+		}
+
+		Eigen::Index num_waves() const {
+			Eigen::Index result = 0;
+			for (const Segment& segment : seq_segments) {
+				result += segment.waves.num_waves();
+			}
+			return result;
+		}
+
+		// End of the last segment
+		WaveT duration() const {
+			WaveT result = static_cast<WaveT>(0);
+			for (const Segment& segment : seq_segments) {
+				result = std::max(result, segment.stop);
+			}
+			return result;
+		}
+
+		// Sampling
+
+		Eigen::ArrayX<WaveT> samples(const Eigen::ArrayX<WaveT>& timestamps) const {
+			Eigen::Index num_samples = timestamps.size();
+			Eigen::ArrayX<WaveT> result = Eigen::ArrayX<WaveT>::Zero(num_samples);
+			std::vector<Eigen::Index> active;
+			for (const Segment& segment : seq_segments) {
+				active.clear();
+				for (Eigen::Index k = 0; k < num_samples; ++k) {
+					if (timestamps(k) >= segment.start && timestamps(k) < segment.stop) { active.push_back(k); }
+				}
+				if (active.empty() || segment.waves.num_waves() == 0) { continue; }
+				Eigen::ArrayX<WaveT> active_timestamps = timestamps(active);
+				result(active) += segment.waves.samples(active_timestamps) * envelope(segment, active_timestamps);
+			}
+			return result;
+		}
+
+		Eigen::ArrayX<WaveT> samples(WaveT duration, std::optional<WaveT> sample_rate = std::nullopt, Eigen::ArrayX<WaveT>* generated_timestamps = nullptr, std::optional<SampleMethod> method = std::nullopt) const {
+			if (generated_timestamps != nullptr) { *generated_timestamps = WaveArray<WaveT>::generate_timestamps(duration, sample_rate); }
+			Eigen::Index num_samples = WaveArray<WaveT>::num_timestamps(duration, sample_rate);
+			if (num_samples < 2) { return this->samples(WaveArray<WaveT>::generate_timestamps(duration, sample_rate)); }
+			// Same grid as WaveArray::generate_timestamps
+			CalcT step = static_cast<CalcT>(duration) / static_cast<CalcT>(num_samples - 1);
+			Eigen::ArrayX<WaveT> result = Eigen::ArrayX<WaveT>::Zero(num_samples);
+			for (const Segment& segment : seq_segments) {
+				if (segment.waves.num_waves() == 0) { continue; }
+				Eigen::Index first = first_sample_at(segment.start, step, num_samples);
+				Eigen::Index last = first_sample_at(segment.stop, step, num_samples);
+				if (first >= last) { continue; }
+				CalcT first_timestamp = static_cast<CalcT>(first) * step;
+				Eigen::ArrayX<WaveT> rendered = segment.waves.samples_uniform(first_timestamp, step, last - first, method);
+				if (segment.fade > 0) {
+					Eigen::ArrayX<CalcT> active_timestamps = Eigen::ArrayX<CalcT>::LinSpaced(last - first, 0, static_cast<CalcT>(last - first - 1)) * step + first_timestamp;
+					rendered *= envelope(segment, active_timestamps.template cast<WaveT>().eval());
+				}
+				result.segment(first, last - first) += rendered;
+			}
+			return result;
+		}
+
+		inline void to_csv_samples(const std::filesystem::path& filename, WaveT duration, WaveT sample_rate, std::string timestamps_title = "Time", std::string samples_title = "Signal") const {
+			Eigen::ArrayX<WaveT> time;
+			Eigen::ArrayX<WaveT> signal = this->samples(duration, sample_rate, &time);
+			save_to_csv(filename, time, signal, timestamps_title, samples_title);
+		}
+
+	private:
+
+		// Index of the first grid sample k * step at or after time, clamped to [0, num_samples]
+		static Eigen::Index first_sample_at(WaveT time, CalcT step, Eigen::Index num_samples) {
+			CalcT exact = static_cast<CalcT>(time) / step;
+			Eigen::Index k = static_cast<Eigen::Index>(std::clamp(std::ceil(exact), static_cast<CalcT>(0), static_cast<CalcT>(num_samples)));
+			// ceil can land one sample off when time sits on the grid
+			while (k > 0 && static_cast<WaveT>(static_cast<CalcT>(k - 1) * step) >= time) { --k; }
+			while (k < num_samples && static_cast<WaveT>(static_cast<CalcT>(k) * step) < time) { ++k; }
+			return k;
+		}
+
+		static Eigen::ArrayX<WaveT> envelope(const Segment& segment, const Eigen::ArrayX<WaveT>& timestamps) {
+			WaveT fade = std::min(segment.fade, (segment.stop - segment.start) / 2);
+			if (!(fade > 0)) { return Eigen::ArrayX<WaveT>::Ones(timestamps.size()); }
+			Eigen::ArrayX<WaveT> fade_in = ((timestamps - segment.start) / fade).min(static_cast<WaveT>(1)).max(static_cast<WaveT>(0));
+			Eigen::ArrayX<WaveT> fade_out = ((segment.stop - timestamps) / fade).min(static_cast<WaveT>(1)).max(static_cast<WaveT>(0));
+			return (static_cast<WaveT>(0.5L) - static_cast<WaveT>(0.5L) * (fade_in * pi<WaveT>()).cos()) * (static_cast<WaveT>(0.5L) - static_cast<WaveT>(0.5L) * (fade_out * pi<WaveT>()).cos());
+		}
+
+		std::vector<Segment> seq_segments;
+	};
+
+	using WaveSeq = WaveSequence<float>;
+	using WaveSeqF = WaveSequence<float>;
+	using WaveSeqD = WaveSequence<double>;
+	using WaveSeqL = WaveSequence<long double>;
+
+} // namespace Cyn
+
+#endif // CYN_WAVE_SEQUENCE_HPP
\ No newline at end of file
@@ -0,0 +1,134 @@
+/*
+ * Except where otherwise noted, Cynthasine  2024 by https://github.com/h2see is licensed under Creative
+ * Commons Attribution-NonCommercial-ShareAlike 4.0 International. To view a
+ * copy of this license, visit https://creativecommons.org/licenses/by-nc-sa/4.0/
+ */
+
+#ifndef CYN_WAVE_STREAM_HPP
+#define CYN_WAVE_STREAM_HPP
+
+#include "CynWave.hpp"
+
+namespace Cyn {
+
+	// Renders a WaveArray block by block at the timestamps k / sample_rate, k = 0, 1, 2, ...
+	// Each wave's phase at the current block is carried as a fraction of a cycle in CalcT (reduced mod 1),
+	// so memory stays constant over the whole render and precision does not decay as time grows.
+	template<NumF WaveT>
+	class WaveStream {
+	public:
+
+		using CalcT = typename WaveArray<WaveT>::CalcT;
+
+		// Constructors
+
+		WaveStream(WaveArray<WaveT> waves, std::optional<WaveT> sample_rate = std::nullopt, Eigen::Index block_size = 4096, std::optional<SampleMethod> method = std::nullopt)
+			: stream_waves(std::move(waves)), stream_sample_rate(sample_rate.value_or(WaveArray<WaveT>::SAMPLE_RATE)), stream_block_size(block_size), stream_method(method) {
+			if (stream_block_size < 1) { throw std::invalid_argument("block_size must be positive."); }
+			if (!(stream_sample_rate > 0)) { throw std::invalid_argument("sample_rate must be positive."); }
+			block_waves = stream_waves;
+			cycles_per_sample = stream_waves.freq().template cast<CalcT>() / static_cast<CalcT>(stream_sample_rate);
+			cycles_per_sample -= cycles_per_sample.floor();
+			this->seek(0);
+		}
+
+		// Accessors
+
+		inline const WaveArray<WaveT>& waves() const {
+			return stream_waves;
+		}
+		inline WaveT sample_rate() const {
+			return stream_sample_rate;
+		}
+		inline Eigen::Index block_size() const {
+			return stream_block_size;
+		}
+		// Index of the next sample to be rendered
+		inline Eigen::Index position() const {
+			return stream_position;
+		}
+		inline CalcT time() const {
+			return static_cast<CalcT>(stream_position) / static_cast<CalcT>(stream_sample_rate);
+		}
+
+		// Positioning
+
+		void seek(Eigen::Index position) {
+			if (position < 0) { throw std::invalid_argument("position must be non-negative."); }
+			stream_position = position;
+			// Cycles elapsed at position, reduced mod 1 (cycles_per_sample is already reduced mod 1)
+			cycles = (cycles_per_sample * static_cast<CalcT>(position)).unaryExpr([](CalcT c) { return c - std::floor(c); });
+		}
+
+		inline void reset() {
+			this->seek(0);
+		}
+
+		// Rendering
+
+		// Renders the next block.size() samples into block and advances the stream
+		void next_into(Eigen::ArrayX<WaveT>& block) {
+			Eigen::Index num_samples = block.size();
+			if (num_samples == 0) { return; }
+			block_waves.phase() = stream_waves.phase() - (cycles * pi<CalcT>(2.0L)).template cast<WaveT>();
+			block = block_waves.samples_uniform(0, static_cast<CalcT>(1) / static_cast<CalcT>(stream_sample_rate), num_samples, stream_method);
+			cycles += cycles_per_sample * static_cast<CalcT>(num_samples);
+			cycles -= cycles.floor();
+			stream_position += num_samples;
+		}
+
+		inline Eigen::ArrayX<WaveT> next(std::optional<Eigen::Index> num_samples = std::nullopt) {
+			Eigen::ArrayX<WaveT> block(num_samples.value_or(stream_block_size));
+			this->next_into(block);
+			return block;
+		}
+
+		// Renders the next num_samples samples in blocks of at most block_size(), calling sink(const Eigen::ArrayX<WaveT>&) on each
+		template<typename Sink>
+		void pump(Eigen::Index num_samples, Sink&& sink) {
+			Eigen::ArrayX<WaveT> block;
+			while (num_samples > 0) {
+				block.resize(std::min(num_samples, stream_block_size));
+				this->next_into(block);
+				sink(static_cast<const Eigen::ArrayX<WaveT>&>(block));
+				num_samples -= block.size();
+			}
+		}
+
+		// Streams the next duration seconds to a csv file without holding the whole render in memory
+		void to_csv_samples(const std::filesystem::path& filename, WaveT duration, std::string timestamps_title = "Time", std::string samples_title = "Signal") {
+			std::ofstream csv_file(filename);
+			if (!csv_file.is_open()) {
+				throw std::runtime_error("Failed to open file: " + filename.string());
+			}
+			csv_file << timestamps_title << "," << samples_title << "\n";
+			Eigen::Index num_samples = WaveArray<WaveT>::num_timestamps(duration, stream_sample_rate);
+			this->pump(num_samples, [&](const Eigen::ArrayX<WaveT>& block) {
+					Eigen::Index block_start = stream_position - block.size();
+					for (Eigen::Index k = 0; k < block.size(); ++k) {
+						csv_file << static_cast<WaveT>(static_cast<CalcT>(block_start + k) / static_cast<CalcT>(stream_sample_rate)) << "," << block(k) << "\n";
+					}
+				}
+			);
+			csv_file.close();
+		}
+
+	private:
+
+		WaveArray<WaveT> stream_waves;
+		WaveArray<WaveT> block_waves; // stream_waves with phases advanced to the current block
+		Eigen::ArrayX<CalcT> cycles_per_sample;
+		Eigen::ArrayX<CalcT> cycles;
+		WaveT stream_sample_rate;
+		Eigen::Index stream_block_size;
+		std::optional<SampleMethod> stream_method;
+		Eigen::Index stream_position = 0;
+	};
+
+	using WaveStreamF = WaveStream<float>;
+	using WaveStreamD = WaveStream<double>;
+	using WaveStreamL = WaveStream<long double>;
+
+} // namespace Cyn
+
+#endif // CYN_WAVE_STREAM_HPP
\ No newline at end of file
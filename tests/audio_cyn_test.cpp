@@ -5,8 +5,13 @@
  */
 
 #include "Cynthasine.h"
+#include "CynResampler.hpp"
+#include "CynRingBuffer.hpp"
 #include "gtest/gtest.h"
 
+#include <future>
+#include <thread>
+
 using namespace Cyn;
 namespace fs = std::filesystem;
 
@@ -38,6 +43,277 @@ private:
     }
 };
 
+TEST_F(WaveTest, RingBuffer) {
+    RingBuffer<float> ring(1000);
+    EXPECT_EQ(ring.capacity(), 1024u);
+    const size_t num_values = 1 << 18;
+    std::thread producer([&]() {
+        std::vector<float> chunk(300);
+        size_t next = 0;
+        while (next < num_values) {
+            size_t chunk_size = std::min(chunk.size(), num_values - next);
+            for (size_t i = 0; i < chunk_size; ++i) { chunk[i] = static_cast<float>(next + i); }
+            size_t written = 0;
+            while (written < chunk_size) {
+                size_t num_written = ring.write(chunk.data() + written, chunk_size - written);
+                if (num_written == 0) { std::this_thread::yield(); }
+                written += num_written;
+            }
+            next += chunk_size;
+        }
+    });
+    std::vector<float> received(num_values);
+    size_t num_read = 0;
+    while (num_read < num_values) {
+        size_t chunk_read = ring.read(received.data() + num_read, std::min<size_t>(256, num_values - num_read));
+        if (chunk_read == 0) { std::this_thread::yield(); }
+        num_read += chunk_read;
+    }
+    producer.join();
+    EXPECT_TRUE(ring.empty());
+    bool in_order = true;
+    for (size_t i = 0; i < num_values; ++i) { in_order = in_order && received[i] == static_cast<float>(i); }
+    EXPECT_TRUE(in_order);
+}
+
+TEST_F(WaveTest, WaveVoice) {
+    Wave waves = Wave::sine(440.0f) + Wave::square(110.0f, 10) + Wave::sine(30000.0f);
+    WaveVoice<float> voice(waves, 44100.0, 0.5);
+    std::vector<float> rendered(2 * 22050 + 200, 0.0f);
+    size_t num_frames = 0;
+    bool is_playing = true;
+    while (is_playing) {
+        is_playing = voice.render(rendered.data() + 2 * num_frames, 300, 2);
+        num_frames += 300;
+    }
+    EXPECT_FALSE(voice.render(rendered.data(), 100, 2));
+
+    Eigen::ArrayXf timestamps = Eigen::ArrayXf::LinSpaced(22050, 0.0f, 22049.0f / 44100.0f);
+    Eigen::ArrayXf expected = waves.filter(waves.freq() <= 22050.0f).samples(timestamps);
+    Eigen::Map<Eigen::ArrayXf, 0, Eigen::InnerStride<2>> left(rendered.data(), 22050);
+    Eigen::Map<Eigen::ArrayXf, 0, Eigen::InnerStride<2>> right(rendered.data() + 1, 22050);
+    EXPECT_TRUE(left.isApprox(expected, 1e-3f));
+    EXPECT_TRUE(right.isApprox(expected, 1e-3f));
+    EXPECT_TRUE(std::all_of(rendered.begin() + 2 * 22050, rendered.end(), [](float x) { return x == 0.0f; }));
+
+    // Many waves rendered in callbacks that do not line up with the voice's blocks
+    Wave harmonics = Wave::sawtooth(55.0f, 300) * 0.5f;
+    WaveVoice<float> block_voice(harmonics, 44100.0, 0.25);
+    std::vector<float> mono(11025, 0.0f);
+    size_t callback_sizes[] = { 37, 64, 1, 200, 129 };
+    for (size_t i = 0, frame = 0; frame < mono.size(); ++i) {
+        size_t size = std::min(callback_sizes[i % 5], mono.size() - frame);
+        block_voice.render(mono.data() + frame, size, 1);
+        frame += size;
+    }
+    Eigen::Map<Eigen::ArrayXf> block_rendered(mono.data(), 11025);
+    Eigen::ArrayXf block_timestamps = Eigen::ArrayXf::LinSpaced(11025, 0.0f, 11024.0f / 44100.0f);
+    Eigen::ArrayXf block_expected = harmonics.filter(harmonics.freq() <= 22050.0f).samples(block_timestamps);
+    EXPECT_TRUE(block_rendered.isApprox(block_expected, 1e-3f));
+
+    WaveVoice<float> silent(Wave::sine(30000.0f), 44100.0, 0.01);
+    std::vector<float> silence(441, 0.0f);
+    EXPECT_FALSE(silent.render(silence.data(), 441, 1));
+    EXPECT_TRUE(std::all_of(silence.begin(), silence.end(), [](float x) { return x == 0.0f; }));
+}
+
+// Adds a constant to every channel for a fixed number of frames
+class ConstantVoice : public Voice {
+public:
+    ConstantVoice(float value, size_t num_frames) : value(value), num_frames_left(num_frames) {}
+
+    bool render(float* output, size_t num_frames, int channel_count) override {
+        size_t num_rendered = std::min(num_frames, num_frames_left);
+        for (size_t i = 0; i < num_rendered * channel_count; ++i) { output[i] += value; }
+        num_frames_left -= num_rendered;
+        return num_frames_left > 0;
+    }
+
+private:
+    float value;
+    size_t num_frames_left;
+};
+
+TEST_F(WaveTest, OfflineBackend) {
+    std::vector<float> samples(10000);
+    for (size_t i = 0; i < samples.size(); ++i) { samples[i] = std::sin(0.01f * static_cast<float>(i)); }
+
+    auto memory_sink = std::make_shared<MemorySink>();
+    Player player(samples, std::nullopt, 44100.0, false, offline_backend(memory_sink, 256));
+    EXPECT_TRUE(player.play());
+    const std::vector<float>& rendered = memory_sink->samples();
+    ASSERT_EQ(rendered.size(), 10240u);
+    EXPECT_TRUE(std::equal(samples.begin(), samples.end(), rendered.begin()));
+    EXPECT_TRUE(std::all_of(rendered.begin() + 10000, rendered.end(), [](float x) { return x == 0.0f; }));
+    EXPECT_EQ(player.num_underruns(), 0u);
+
+    // The first run released the samples, a voice keeps playback going on its own and starts at its own frame
+    EXPECT_EQ(player.num_queued_frames(), 0u);
+    memory_sink->clear();
+    player.schedule_voice(std::make_unique<ConstantVoice>(0.5f, 1000), 12000.0 / 44100.0);
+    EXPECT_TRUE(player.play());
+    ASSERT_EQ(memory_sink->samples().size(), 13056u);
+    EXPECT_EQ(memory_sink->samples()[11999], 0.0f);
+    EXPECT_TRUE(std::all_of(memory_sink->samples().begin() + 12000, memory_sink->samples().begin() + 13000, [](float x) { return x == 0.5f; }));
+
+    fs::path wav_path = misc_output_dir / "offline_backend.wav";
+    {
+        auto wav_sink = std::make_shared<WavSink>(wav_path);
+        Player wav_player(samples, samples, std::nullopt, 48000.0, false, offline_backend(wav_sink, 500));
+        EXPECT_TRUE(wav_player.play());
+    }
+    EXPECT_EQ(fs::file_size(wav_path), 44u + 2u * 2u * 10500u);
+
+    auto null_sink = std::make_shared<NullSink>();
+    Player null_player(std::vector<float>(441000, 0.25f), std::nullopt, 44100.0, false, offline_backend(null_sink, 1024));
+    EXPECT_TRUE(null_player.play());
+    EXPECT_EQ(null_sink->num_frames(), 431u * 1024u);
+    EXPECT_EQ(null_sink->num_blocks(), 431u);
+    EXPECT_GT(null_sink->realtime_factor(), 1.0);
+}
+
+TEST_F(WaveTest, AddSamples) {
+    std::vector<float> ramp(1000);
+    std::iota(ramp.begin(), ramp.end(), 1.0f);
+
+    auto memory_sink = std::make_shared<MemorySink>();
+    Player player(std::vector<float>{}, std::nullopt, 1000.0, false, offline_backend(memory_sink, 100));
+    std::vector<float> moved = ramp;
+    const float* moved_data = moved.data();
+    player.add_samples(std::move(moved));
+    EXPECT_TRUE(moved.empty() && moved.data() != moved_data);
+    player.add_silence(0.5);
+    player.add_samples(std::span<const float>(ramp).subspan(0, 250));
+    player.add_samples(ramp);
+    EXPECT_TRUE(player.play());
+
+    const std::vector<float>& rendered = memory_sink->samples();
+    ASSERT_EQ(rendered.size(), 2800u);
+    EXPECT_TRUE(std::equal(ramp.begin(), ramp.end(), rendered.begin()));
+    EXPECT_TRUE(std::all_of(rendered.begin() + 1000, rendered.begin() + 1500, [](float x) { return x == 0.0f; }));
+    EXPECT_TRUE(std::equal(ramp.begin(), ramp.begin() + 250, rendered.begin() + 1500));
+    EXPECT_TRUE(std::equal(ramp.begin(), ramp.end(), rendered.begin() + 1750));
+    EXPECT_TRUE(std::all_of(rendered.begin() + 2750, rendered.end(), [](float x) { return x == 0.0f; }));
+    EXPECT_EQ(player.num_queued_frames(), 0u);
+
+    // Looping keeps every chunk
+    auto loop_sink = std::make_shared<MemorySink>();
+    Player loop_player(ramp, 2.5, 1000.0, true, offline_backend(loop_sink, 100));
+    loop_player.add_silence(0.25);
+    EXPECT_TRUE(loop_player.play());
+    EXPECT_EQ(loop_player.num_queued_frames(), 1250u);
+    ASSERT_EQ(loop_sink->samples().size(), 2800u);
+    EXPECT_TRUE(std::equal(ramp.begin(), ramp.end(), loop_sink->samples().begin() + 1250));
+    EXPECT_TRUE(std::all_of(loop_sink->samples().begin() + 2250, loop_sink->samples().begin() + 2500, [](float x) { return x == 0.0f; }));
+    EXPECT_TRUE(std::equal(ramp.begin(), ramp.begin() + 250, loop_sink->samples().begin() + 2500));
+
+    auto stereo_sink = std::make_shared<MemorySink>();
+    Player stereo_player(std::vector<float>{}, std::vector<float>{}, std::nullopt, 1000.0, false, offline_backend(stereo_sink, 100));
+    EXPECT_THROW(stereo_player.add_samples(std::span<const float>(ramp), std::span<const float>(ramp).subspan(0, 999)), std::length_error);
+    stereo_player.add_samples(std::span<const float>(ramp), std::span<const float>(ramp));
+    stereo_player.add_silence(0.1);
+    stereo_player.add_interleaved_samples({ 1.0f, -1.0f, 2.0f, -2.0f });
+    EXPECT_THROW(stereo_player.add_interleaved_samples({ 1.0f }), std::length_error);
+    EXPECT_THROW(stereo_player.add_samples(ramp), std::runtime_error);
+    stereo_player.add_samples(ramp, ramp);
+    EXPECT_TRUE(stereo_player.play());
+    const std::vector<float>& stereo = stereo_sink->samples();
+    ASSERT_EQ(stereo.size(), 2u * 2200u);
+    EXPECT_EQ(stereo[2 * 999], 1000.0f);
+    EXPECT_EQ(stereo[2 * 999 + 1], 1000.0f);
+    EXPECT_EQ(stereo[2 * 1050], 0.0f);
+    EXPECT_EQ(stereo[2 * 1101 + 1], -2.0f);
+    EXPECT_EQ(stereo[2 * 1102 + 1], 1.0f);
+
+    // A producer that falls behind a stream which then finishes on its own is not held back forever
+    auto late_sink = std::make_shared<MemorySink>();
+    Player late_player(std::vector<float>{}, std::nullopt, 1000.0, false, offline_backend(late_sink, 100, 1.0));
+    EXPECT_TRUE(late_player.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    std::future<void> producer = std::async(std::launch::async, [&]() {
+        for (int i = 0; i < 50; ++i) { late_player.add_samples(ramp); }
+    });
+    EXPECT_EQ(producer.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    late_player.stop();
+
+    // Frames already in the ring when playback stops are played after the next start, not dropped
+    std::vector<float> long_ramp(5000);
+    std::iota(long_ramp.begin(), long_ramp.end(), 1.0f);
+    auto resume_sink = std::make_shared<MemorySink>();
+    Player resume_player(long_ramp, std::nullopt, 1000.0, false, offline_backend(resume_sink, 100, 10.0));
+    EXPECT_TRUE(resume_player.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    resume_player.stop();
+    size_t num_stopped = resume_sink->samples().size();
+    EXPECT_GT(num_stopped, 0u);
+    EXPECT_LT(num_stopped, long_ramp.size());
+    EXPECT_TRUE(resume_player.play());
+    std::vector<float> resumed;
+    std::copy_if(resume_sink->samples().begin(), resume_sink->samples().end(), std::back_inserter(resumed), [](float x) { return x != 0.0f; });
+    EXPECT_EQ(resumed, long_ramp);
+}
+
+TEST_F(WaveTest, Resampler) {
+    const double pi_2 = 2.0 * pi<double>();
+    for (auto [input_rate, output_rate] : std::vector<std::pair<double, double>>{ {44100.0, 48000.0}, {96000.0, 48000.0}, {8000.0, 48000.0}, {48000.0, 44101.0} }) {
+        size_t num_input = static_cast<size_t>(input_rate) / 2;
+        std::vector<float> input(2 * num_input);
+        for (size_t i = 0; i < num_input; ++i) {
+            input[2 * i] = static_cast<float>(std::sin(pi_2 * 1000.0 * i / input_rate));
+            input[2 * i + 1] = static_cast<float>(0.5 * std::cos(pi_2 * 250.0 * i / input_rate));
+        }
+        Resampler resampler(input_rate, output_rate, 2);
+        std::vector<float> output;
+        for (size_t pos = 0; pos < num_input; pos += 777) {
+            size_t num_frames = std::min<size_t>(777, num_input - pos);
+            size_t expected_frames = resampler.output_frames(num_frames);
+            size_t num_values = output.size();
+            resampler.process(input.data() + 2 * pos, num_frames, output);
+            EXPECT_EQ(output.size() - num_values, 2 * expected_frames);
+            EXPECT_LE(resampler.output_frames(resampler.input_frames(100)), 100u);
+        }
+        resampler.flush(output);
+        size_t num_output = output.size() / 2;
+        EXPECT_EQ(num_output, static_cast<size_t>(std::ceil(num_input * std::round(output_rate) / std::round(input_rate))));
+        double max_error = 0.0;
+        for (size_t k = 100; k < num_output - 100; ++k) {
+            max_error = std::max(max_error, std::abs(output[2 * k] - std::sin(pi_2 * 1000.0 * k / output_rate)));
+            max_error = std::max(max_error, std::abs(output[2 * k + 1] - 0.5 * std::cos(pi_2 * 250.0 * k / output_rate)));
+        }
+        EXPECT_LT(max_error, 1e-3);
+    }
+
+    // A player renders at the backend's rate, its voices included
+    std::vector<float> samples(22050);
+    for (size_t i = 0; i < samples.size(); ++i) { samples[i] = static_cast<float>(0.5 * std::sin(pi_2 * 440.0 * i / 22050.0)); }
+    auto memory_sink = std::make_shared<MemorySink>();
+    Player player(samples, std::nullopt, 22050.0, false, offline_backend(memory_sink, 256, 0.0, 48000.0));
+    player.schedule_voice(std::make_unique<WaveVoice<float>>(Wave::sine(1000.0f, 0.25f), 22050.0, 0.25), 0.5);
+    EXPECT_TRUE(player.play());
+    EXPECT_EQ(player.sample_rate(), 22050.0);
+    EXPECT_EQ(player.output_sample_rate(), 48000.0);
+    const std::vector<float>& rendered = memory_sink->samples();
+    ASSERT_GE(rendered.size(), 48000u);
+    EXPECT_EQ(player.num_underruns(), 0u);
+    double max_error = 0.0;
+    for (size_t k = 100; k < 47900; ++k) {
+        double t = k / 48000.0;
+        double expected = 0.5 * std::sin(pi_2 * 440.0 * t) + (t >= 0.5 && t < 0.75 ? 0.25 * std::sin(pi_2 * 1000.0 * (t - 0.5)) : 0.0);
+        max_error = std::max(max_error, std::abs(rendered[k] - expected));
+    }
+    EXPECT_LT(max_error, 1e-3);
+}
+
+TEST_F(WaveTest, PlayerRegistry) {
+    Player& player = get_player(44100.0);
+    EXPECT_EQ(&player, &get_player(44100.0));
+    EXPECT_EQ(&player, &Wave::player());
+    EXPECT_NE(&player, &get_player(48000.0));
+    EXPECT_EQ(&get_player(96000.0), &get_player(96000.2));
+    EXPECT_EQ(&get_player(22050.4), &get_player(22049.6));
+    EXPECT_EQ(get_player(22049.6).sample_rate(), 22050.0);
+}
+
 TEST_F(WaveTest, LoadPlaySamples) {
     std::vector<std::string> header;
     Eigen::ArrayXXf uke_signal = load_from_csv<float>(audio_dir / "Ukulele.csv", &header);
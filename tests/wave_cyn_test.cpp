@@ -100,6 +100,159 @@ TEST_F(WaveTest, FromSamplesFourier) {
     EXPECT_TRUE(result.samples(2.0f).isApprox(test_samples, tolerance));
 }
 
+TEST_F(WaveTest, FFTContext) {
+    FFT::Context context;
+    for (Eigen::Index size : { Eigen::Index(8), Eigen::Index(7), Eigen::Index(1) }) {
+        Eigen::ArrayXd frame = Eigen::ArrayXd::Random(size);
+        Eigen::ArrayX<std::complex<double>> dft(size / 2 + 1);
+        for (Eigen::Index k = 0; k < dft.size(); ++k) {
+            dft(k) = 0.0;
+            for (Eigen::Index n = 0; n < size; ++n) {
+                dft(k) += frame(n) * std::polar(1.0, -2.0 * pi<double>() * static_cast<double>(k * n) / static_cast<double>(size));
+            }
+        }
+        Eigen::ArrayX<std::complex<double>> spectrum;
+        context.r2c(frame, spectrum);
+        EXPECT_TRUE(spectrum.isApprox(dft, 1e-9));
+        context.r2c(frame, spectrum, true);
+        EXPECT_TRUE(spectrum.isApprox(dft.conjugate() / static_cast<double>(size), 1e-9));
+    }
+    EXPECT_EQ(context.num_plans(), 3u);
+
+    Eigen::ArrayXf frame = Eigen::ArrayXf::Random(64);
+    Eigen::ArrayX<std::complex<float>> spectrum;
+    context.r2c(frame, spectrum);
+    const std::complex<float>* buffer = spectrum.data();
+    context.r2c(frame * 0.5f, spectrum);
+    EXPECT_EQ(spectrum.data(), buffer);
+    EXPECT_TRUE(spectrum.isApprox(FFT::r2c(frame) * 0.5f, 1e-5f));
+    EXPECT_EQ(context.num_plans(), 4u);
+
+    Eigen::ArrayX<std::complex<float>> signal = Eigen::ArrayX<std::complex<float>>::Random(48);
+    Eigen::ArrayX<std::complex<float>> roundtrip = context.c2c(signal);
+    context.c2c_inplace(roundtrip, true);
+    EXPECT_TRUE(roundtrip.isApprox(signal, 1e-5f));
+
+    std::vector<std::thread> threads;
+    std::vector<Eigen::ArrayX<std::complex<float>>> results(4);
+    for (size_t i = 0; i < results.size(); ++i) {
+        threads.emplace_back([&, i]() { for (int j = 0; j < 50; ++j) { context.r2c(frame, results[i]); } });
+    }
+    for (std::thread& thread : threads) { thread.join(); }
+    for (const Eigen::ArrayX<std::complex<float>>& result : results) { EXPECT_TRUE(result.isApprox(FFT::r2c(frame), 1e-5f)); }
+    EXPECT_EQ(context.num_plans(), 5u);
+    context.clear();
+    EXPECT_EQ(context.num_plans(), 0u);
+}
+
+TEST_F(WaveTest, BatchedFFT) {
+    Eigen::ArrayXXf frames = Eigen::ArrayXXf::Random(64, 5);
+    Eigen::ArrayXX<std::complex<float>> by_columns = FFT::r2c_columns(frames, false, 2);
+    Eigen::ArrayXX<std::complex<float>> by_rows = FFT::r2c_rows(frames.transpose().eval(), false, 2);
+    ASSERT_EQ(by_columns.rows(), 33);
+    ASSERT_EQ(by_rows.cols(), 33);
+    for (Eigen::Index i = 0; i < frames.cols(); ++i) {
+        Eigen::ArrayX<std::complex<float>> single = FFT::r2c(frames.col(i).eval());
+        EXPECT_TRUE(by_columns.col(i).isApprox(single, 1e-5f));
+        EXPECT_TRUE(by_rows.row(i).transpose().isApprox(single, 1e-5f));
+    }
+    Eigen::ArrayXX<std::complex<float>> strided = FFT::r2c_columns(frames.middleRows(0, 32), true);
+    EXPECT_TRUE(strided.col(3).isApprox(FFT::r2c(frames.col(3).head(32).eval(), true), 1e-5f));
+
+    Eigen::ArrayXX<std::complex<float>> spectra = FFT::c2c_rows(by_rows, false, 2);
+    Eigen::ArrayXX<std::complex<float>> roundtrip = FFT::c2c_columns(FFT::c2c_columns(by_columns), true);
+    EXPECT_TRUE(roundtrip.isApprox(by_columns, 1e-5f));
+    EXPECT_TRUE(spectra.row(2).transpose().isApprox(FFT::c2c(by_rows.row(2).transpose().eval()), 1e-4f));
+}
+
+TEST_F(WaveTest, WaveAnalyzer) {
+    float sample_rate = 8000.0f;
+    Eigen::ArrayXf timestamps = Eigen::ArrayXf::LinSpaced(3000, 0.0f, 2999.0f) / sample_rate;
+    Eigen::ArrayXf signal = Wave::sine(440.0f, 0.5f).samples(timestamps);
+    signal.tail(1500) += Wave::sine(1234.5f, 0.25f, 1.0f).samples(timestamps.tail(1500).eval());
+
+    WaveAnalyzerF analyzer(256, 64, 512, sample_rate, -1.0f);
+    analyzer.push(signal.head(100));
+    analyzer.push(signal.segment(100, 37));
+    EXPECT_EQ(analyzer.num_frames_ready(), 2);
+    analyzer.push(signal.tail(2863));
+    analyzer.flush();
+    EXPECT_EQ(analyzer.num_samples(), 3000);
+    EXPECT_EQ(analyzer.num_frames_ready(), (3000 + 256 - 64 + 63) / 64);
+    WaveSeqF sequence = analyzer.to_sequence();
+    EXPECT_EQ(analyzer.num_frames_ready(), 0);
+    EXPECT_LT((sequence.samples(timestamps) - signal).abs().maxCoeff(), tolerance);
+    EXPECT_THROW(analyzer.push(signal), std::logic_error);
+
+    WaveSeqF compact = WaveAnalyzerF::analyze(signal, 256, 128, std::nullopt, sample_rate, 1e-3f, 12);
+    for (const WaveSeqF::Segment& segment : compact.segments()) {
+        EXPECT_LE(segment.waves.num_waves(), 12);
+    }
+    EXPECT_LT(compact.num_waves(), sequence.num_waves());
+    Eigen::ArrayXf compact_error = (compact.samples(timestamps) - signal).abs();
+    EXPECT_LT(compact_error.segment(300, 1000).maxCoeff(), 0.01f);
+    EXPECT_LT(compact_error.segment(1800, 900).maxCoeff(), 0.01f);
+
+    // Five minutes in, a quarter rate sine still analyzes to phase 0 (sin(pi n / 2) is exact in float)
+    Eigen::ArrayXf quarter(300000);
+    for (Eigen::Index n = 0; n < quarter.size(); ++n) { quarter(n) = static_cast<float>((n % 2) * (1 - (n % 4))); }
+    WaveAnalyzerF late_analyzer(256, 256, std::nullopt, 1000.0f, 1e-3f);
+    late_analyzer.push(quarter);
+    WaveAnalyzerF::Frame late_frame;
+    while (late_analyzer.next(late_frame)) {}
+    EXPECT_EQ(late_frame.start, 299520.0 / 1000.0);
+    Eigen::Index peak;
+    late_frame.waves.amp().abs().maxCoeff(&peak);
+    EXPECT_EQ(late_frame.waves(peak, 0), 250.0f);
+    float late_phase = posmod(late_frame.waves(peak, 2) + pi<float>(), 2.0f * pi<float>()) - pi<float>();
+    EXPECT_LT(std::abs(late_phase), 1e-4f);
+}
+
+TEST_F(WaveTest, FromSamplesThreaded) {
+    Eigen::ArrayXf noise = Eigen::ArrayXf::Random(Eigen::Index(1) << 18);
+    Wave all_bins = Wave::from_samples(noise, 8000.0f, -1.0f);
+    ASSERT_EQ(all_bins.num_waves(), (Eigen::Index(1) << 17) + 1);
+    EXPECT_TRUE(Wave::from_samples(noise, 8000.0f, -1.0f, 4) == all_bins);
+    Wave fused = Wave::from_samples(noise, 8000.0f, 0.005f, 4);
+    Wave filtered = all_bins.remove_zero(0.005f);
+    ASSERT_EQ(fused.num_waves(), filtered.num_waves());
+    EXPECT_LT(fused.num_waves(), all_bins.num_waves());
+    EXPECT_TRUE(fused == filtered);
+
+    Eigen::ArrayXf short_noise = Eigen::ArrayXf::Random(101);
+    Eigen::ArrayXf timestamps = Eigen::ArrayXf::LinSpaced(101, 0.0f, 100.0f) / 100.0f;
+    for (Eigen::Index size : { Eigen::Index(101), Eigen::Index(100) }) {
+        Wave waves = Wave::from_samples(short_noise.head(size).eval(), 100.0f, -1.0f);
+        EXPECT_TRUE(waves.samples(timestamps.head(size).eval()).isApprox(short_noise.head(size), tolerance));
+    }
+}
+
+TEST_F(WaveTest, FromSamplesSparse) {
+    float sample_rate = 8000.0f;
+    Eigen::ArrayXf timestamps = Eigen::ArrayXf::LinSpaced(8000, 0.0f, 7999.0f) / sample_rate;
+    Wave partials = Wave::sine(440.3f, 1.0f, 0.5f) + Wave::sine(1000.7f, 0.5f, 2.0f) + Wave::sine(2500.2f, 0.25f, 4.0f);
+    Eigen::ArrayXf recording = partials.samples(timestamps);
+    EXPECT_GT(Wave::from_samples(recording, sample_rate).num_waves(), 500);
+
+    Wave peaks = Wave::from_samples_peaks(recording, sample_rate, 64, 0.05f);
+    ASSERT_EQ(peaks.num_waves(), 3);
+    for (Eigen::Index i = 0; i < 3; ++i) {
+        EXPECT_NEAR(peaks(i, 0), partials(i, 0), 0.01f);
+        EXPECT_NEAR(peaks(i, 1), partials(i, 1), 0.01f * partials(i, 1));
+    }
+    EXPECT_LT((peaks.samples(timestamps) - recording).abs().maxCoeff(), 0.05f);
+    EXPECT_EQ(Wave::from_samples_peaks(recording, sample_rate, 2, 0.05f).num_waves(), 2);
+
+    Eigen::ArrayXf square = Wave::square(10.0f, 100).samples(timestamps);
+    Wave top = Wave::from_samples_top(square, sample_rate, 4000, 0.05f);
+    EXPECT_LT(top.num_waves(), 100);
+    float rms_error = std::sqrt((top.samples(timestamps) - square).square().mean() / square.square().mean());
+    EXPECT_LE(rms_error, 0.05f);
+    EXPECT_GT(rms_error, 0.03f);
+    EXPECT_EQ(Wave::from_samples_top(square, sample_rate, 10).num_waves(), 10);
+    EXPECT_TRUE(Wave::from_samples_top(square, sample_rate, 100).samples(timestamps).isApprox(square, tolerance));
+}
+
 TEST_F(WaveTest, Pulse) {
     Wave result = Wave::pulse(2.0f, 0.66f, 30);
     result.to_csv_samples(misc_output_dir / "Pulse.csv", 1.0f, 2 * result.nyquist_rate());
@@ -112,6 +265,276 @@ TEST_F(WaveTest, Join) {
     result.to_csv_samples(misc_output_dir / "Join.csv", 15.0f, 2 * result.nyquist_rate());
 }
 
+TEST_F(WaveTest, SamplesPhasor) {
+    Wave waves = random_waves[0] * random_waves[1] + Wave::square(440.0f, 20);
+    Eigen::ArrayXf direct = waves.samples(1.5f, 8000.0f, nullptr, SampleMethod::Direct);
+    Eigen::ArrayXf phasor = waves.samples(1.5f, 8000.0f, nullptr, SampleMethod::Phasor);
+    EXPECT_EQ(direct.size(), phasor.size());
+    EXPECT_TRUE(phasor.isApprox(direct, tolerance));
+}
+
+TEST_F(WaveTest, SamplesIFFT) {
+    Eigen::ArrayXf signal = random_waves[0].samples(0.5f, 8000.0f);
+    Wave spectrum = Wave::from_samples(signal, 8000.0f);
+    Eigen::ArrayXf direct = spectrum.samples(0.5f, 8000.0f, nullptr, SampleMethod::Direct);
+    Eigen::ArrayXf ifft = spectrum.samples(0.5f, 8000.0f, nullptr, SampleMethod::IFFT);
+    EXPECT_TRUE(ifft.isApprox(direct, tolerance));
+    EXPECT_THROW(random_waves[0].samples(0.5f, 8000.0f, nullptr, SampleMethod::IFFT), std::invalid_argument);
+}
+
+TEST_F(WaveTest, SamplesNUFFT) {
+    Wave waves = random_waves[0] * random_waves[1];
+    Eigen::ArrayXf direct = waves.samples(1.5f, 8000.0f, nullptr, SampleMethod::Direct);
+    Eigen::ArrayXf nufft = waves.samples(1.5f, 8000.0f, nullptr, SampleMethod::NUFFT);
+    EXPECT_TRUE(nufft.isApprox(direct, tolerance));
+}
+
+TEST_F(WaveTest, LazyProduct) {
+    LazyWave lazy_wave = (lazy(random_waves[0]) + 1.0f) * random_waves[1] * 0.5f - random_waves[0];
+    Wave eager_wave = (random_waves[0] + 1.0f) * random_waves[1] * 0.5f - random_waves[0];
+    EXPECT_EQ(lazy_wave.num_terms(), 3);
+    EXPECT_EQ(lazy_wave.eval_num_waves(), lazy_wave.eval().num_waves());
+    Eigen::ArrayXf eager = eager_wave.samples(1.0f, 4000.0f, nullptr, SampleMethod::Direct);
+    EXPECT_TRUE(lazy_wave.samples(1.0f, 4000.0f).isApprox(eager, tolerance));
+    EXPECT_TRUE(lazy_wave.eval().samples(1.0f, 4000.0f).isApprox(eager, tolerance));
+    EXPECT_TRUE((lazy(random_waves[0]) - 2u).eval().samples(1.0f, 4000.0f).isApprox((random_waves[0] - 2.0f).samples(1.0f, 4000.0f), tolerance));
+}
+
+TEST_F(WaveTest, Interfere) {
+    Wave waves = random_waves[0] + random_waves[0] - random_waves[1] + random_waves[1].shift(0.0f) + Wave::sine(3.0f, 1.0f, pi<float>()) + Wave::sine(3.0f);
+    Wave interfered = waves.interfere();
+    EXPECT_EQ(interfered.num_waves(), random_waves[0].remove_zero().num_waves());
+    EXPECT_TRUE(waves == random_waves[0] * 2.0f);
+    EXPECT_TRUE(interfered.samples(2.0f, 1000.0f).isApprox(waves.samples(2.0f, 1000.0f), tolerance));
+}
+
+TEST_F(WaveTest, InterferePhasor) {
+    Wave waves = Wave::sine(20.0f, 1.0f, 0.3f) + Wave::sine(20.0f, 2.0f, 1.1f) + Wave::cosine(20.0f, 0.5f) + random_waves[0];
+    Wave interfered = waves.interfere(std::nullopt, InterfereMode::Phasor);
+    EXPECT_EQ(interfered.num_waves(), random_waves[0].interfere(std::nullopt, InterfereMode::Phasor).num_waves() + 1);
+    EXPECT_TRUE(interfered.samples(2.0f, 1000.0f).isApprox(waves.samples(2.0f, 1000.0f), tolerance));
+
+    Eigen::ArrayXf timestamps = Eigen::ArrayXf::LinSpaced(300, 0.0f, 299.0f) / 600.0f;
+    Eigen::ArrayXf signal = random_waves[1].samples(timestamps);
+    Wave spectrum = Wave::from_samples(signal, 600.0f, -1.0f);
+    EXPECT_EQ(spectrum.num_waves(), signal.size() / 2 + 1);
+    EXPECT_TRUE(spectrum.samples(timestamps).isApprox(signal, tolerance));
+    Wave respectrum = spectrum.interfere(std::nullopt, InterfereMode::Phasor);
+    EXPECT_EQ(respectrum.num_waves(), spectrum.num_waves());
+    EXPECT_TRUE(respectrum.samples(timestamps).isApprox(signal, tolerance));
+}
+
+TEST_F(WaveTest, CompactPolicy) {
+    Wave::COMPACT_STATS = CompactStats{};
+    Wave unbounded;
+    for (int i = 0; i < 20; ++i) {
+        Wave envelope = (Wave::cosine(2.0f, -1.0f) + 1.0f) * 0.5f;
+        unbounded += envelope * Wave::sine(440.0f);
+    }
+    EXPECT_EQ(Wave::COMPACT_STATS.checks, 0u);
+
+    Wave::COMPACT_POLICY.enabled = true;
+    Wave::COMPACT_POLICY.max_waves = 16;
+    Wave bounded;
+    for (int i = 0; i < 20; ++i) {
+        Wave envelope = (Wave::cosine(2.0f, -1.0f) + 1.0f) * 0.5f;
+        bounded += envelope * Wave::sine(440.0f);
+    }
+    Wave::COMPACT_POLICY = CompactPolicy<float>{};
+    EXPECT_LT(bounded.num_waves(), 16);
+    EXPECT_GT(Wave::COMPACT_STATS.compactions, 0u);
+    EXPECT_GT(Wave::COMPACT_STATS.waves_saved(), 0u);
+    EXPECT_TRUE(bounded.samples(1.0f, 4000.0f).isApprox(unbounded.samples(1.0f, 4000.0f), tolerance));
+    EXPECT_LT(unbounded.compact().num_waves(), unbounded.num_waves());
+
+    Wave::COMPACT_STATS = CompactStats{};
+    Wave::COMPACT_POLICY.enabled = true;
+    Wave::COMPACT_POLICY.max_waves = 16;
+    Wave::COMPACT_POLICY.rearm_ratio = 2.0;
+    Wave accumulator;
+    Wave copied;
+    for (int i = 0; i < 200; ++i) {
+        accumulator += Wave::sine(100.0f + static_cast<float>(i), 0.01f);
+        copied = Wave(copied) + Wave::sine(100.0f + static_cast<float>(i), 0.01f);
+    }
+    EXPECT_EQ(accumulator.num_waves(), 200);
+    EXPECT_EQ(copied.num_waves(), 200);
+    EXPECT_EQ(Wave::COMPACT_STATS.compactions, 8u);
+
+    Wave::COMPACT_STATS = CompactStats{};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([]() {
+            Wave local;
+            for (int i = 0; i < 500; ++i) { local += Wave::sine(100.0f, 0.01f); }
+        });
+    }
+    for (std::thread& thread : threads) { thread.join(); }
+    Wave::COMPACT_POLICY = CompactPolicy<float>{};
+    EXPECT_EQ(Wave::COMPACT_STATS.checks, 2000u);
+}
+
+TEST_F(WaveTest, RenderCache) {
+    Wave chord = Wave::sine(440.0f, 0.5f) + Wave::sine(660.0f, 0.25f, 1.0f);
+    Wave reordered = chord.colwise().reverse();
+    reordered(1, 2) = 2.0f * pi<float>();
+    EXPECT_EQ(chord.content_hash(), reordered.content_hash());
+    Wave nudged = chord;
+    nudged(0, 1) += 1e-5f;
+    EXPECT_NE(chord.content_hash(), nudged.content_hash());
+    EXPECT_EQ(chord.content_hash(1e-3f), nudged.content_hash(1e-3f));
+
+    Wave::clear_render_cache();
+    Wave::RENDER_CACHE_STATS = RenderCacheStats{};
+    Wave::RENDER_CACHE_POLICY.enabled = true;
+    Wave::RENDER_CACHE_POLICY.max_bytes = 2 * 4410 * sizeof(float);
+    Eigen::ArrayXf first = chord.samples(0.1f);
+    Eigen::ArrayXf second = reordered.samples(0.1f);
+    chord.samples(0.1f, 22050.0f);
+    chord.samples(0.1f, std::nullopt, nullptr, SampleMethod::Direct);
+    chord.samples(0.1f);
+    Wave::RENDER_CACHE_POLICY = RenderCachePolicy<float>{};
+    EXPECT_TRUE(first.isApprox(second));
+    EXPECT_EQ(Wave::RENDER_CACHE_STATS.misses, 4u);
+    EXPECT_EQ(Wave::RENDER_CACHE_STATS.hits, 1u);
+    EXPECT_EQ(Wave::RENDER_CACHE_STATS.evictions, 2u);
+    EXPECT_EQ(Wave::RENDER_CACHE_STATS.entries, 2u);
+    EXPECT_EQ(Wave::RENDER_CACHE_STATS.bytes, 2 * 4410 * sizeof(float));
+    Wave::clear_render_cache();
+    EXPECT_EQ(Wave::RENDER_CACHE_STATS.entries, 0u);
+
+    // Globals that change the render are part of the key
+    Wave::RENDER_CACHE_STATS = RenderCacheStats{};
+    Wave::RENDER_CACHE_POLICY.enabled = true;
+    Wave square = Wave::square(100.0f, 20);
+    square.samples(0.1f);
+    Wave::PERIODIC_TILING = true;
+    Eigen::ArrayXf tiled = square.samples(0.1f);
+    Wave::PERIODIC_TILING = false;
+    float saved_tolerance = Wave::TOLERANCE;
+    Wave::TOLERANCE = 1e-2f;
+    square.samples(0.1f);
+    Wave::TOLERANCE = saved_tolerance;
+    Eigen::ArrayXf untiled = square.samples(0.1f);
+    Wave::RENDER_CACHE_POLICY = RenderCachePolicy<float>{};
+    EXPECT_EQ(Wave::RENDER_CACHE_STATS.misses, 3u);
+    EXPECT_EQ(Wave::RENDER_CACHE_STATS.hits, 1u);
+    EXPECT_TRUE(tiled.isApprox(untiled, 1e-3f));
+    Wave::clear_render_cache();
+
+    // A NaN parameter hashes alike but never compares equal, so the stored key must be checked on lookup
+    RenderCache<float> cache;
+    RenderCacheStats stats;
+    Wave broken = Wave::sine(440.0f, std::numeric_limits<float>::quiet_NaN());
+    RenderKey<float> key{ broken.content_rows(), 0.1f, 44100.0f, 0, 4410 };
+    cache.insert(key, first, 1 << 20, stats);
+    Eigen::ArrayXf found;
+    EXPECT_FALSE(cache.find(key, found, stats));
+    key.rows = chord.content_rows();
+    cache.insert(key, first, 1 << 20, stats);
+    EXPECT_TRUE(cache.find(key, found, stats));
+    key.num_samples = 4411;
+    EXPECT_FALSE(cache.find(key, found, stats));
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.misses, 2u);
+}
+
+TEST_F(WaveTest, PeriodicTiling) {
+    Wave square = Wave::square(100.0f, 20);
+    ASSERT_TRUE(square.fundamental().has_value());
+    EXPECT_NEAR(square.fundamental().value(), 100.0, 1e-9);
+    EXPECT_NEAR((Wave::sine(300.0f) + Wave::sine(450.0f, 0.5f, 1.0f)).period().value(), 1.0 / 150.0, 1e-12);
+    EXPECT_FALSE((Wave::sine(440.0f) + Wave::sine(440.0f * std::sqrt(2.0f))).fundamental(std::nullopt, 1.0).has_value());
+    EXPECT_EQ(square.period_size(1.0 / 44100.0, 44100), 441);
+    EXPECT_FALSE(square.period_size(1.0 / 44100.0, 441).has_value());
+
+    Wave chord = square * Wave::sine(2.0f) + Wave::triangle(150.0f, 10);
+    Eigen::ArrayXf untiled = chord.samples_uniform(0.0, 1.0 / 44100.0, 44100, SampleMethod::Phasor);
+    Wave::PERIODIC_TILING = true;
+    Eigen::ArrayXf tiled = chord.samples_uniform(0.0, 1.0 / 44100.0, 44100, SampleMethod::Phasor);
+    Eigen::ArrayXf tiled_direct = chord.samples_uniform(0.0, 1.0 / 44100.0, 44100, SampleMethod::Direct);
+    Wave::PERIODIC_TILING = false;
+    EXPECT_EQ(chord.period_size(1.0 / 44100.0, 44100), 22050);
+    EXPECT_EQ(tiled.size(), untiled.size());
+    EXPECT_LT((tiled - untiled).abs().maxCoeff(), tolerance);
+    EXPECT_LT((tiled_direct.head(4410) - untiled.head(4410)).abs().maxCoeff(), tolerance);
+    EXPECT_TRUE((tiled_direct.segment(22050, 22050) == tiled_direct.head(22050)).all());
+}
+
+TEST_F(WaveTest, MultiplyInto) {
+    Wave product;
+    multiply_into(product, random_waves[0], random_waves[1]);
+    EXPECT_EQ(product.num_waves(), 2 * random_waves[0].num_waves() * random_waves[1].num_waves());
+    const float* buffer = product.data();
+    multiply_into(product, random_waves[1], random_waves[0]);
+    EXPECT_EQ(product.data(), buffer);
+    EXPECT_TRUE(product.isApprox(random_waves[1] * random_waves[0]));
+
+    Wave aliased = random_waves[0];
+    multiply_into(aliased, aliased, random_waves[1]);
+    EXPECT_TRUE(aliased.isApprox(random_waves[0] * random_waves[1]));
+}
+
+TEST_F(WaveTest, Pow) {
+    Wave harmonics = Wave::square(2.0f, 64);
+    Eigen::ArrayXf base = harmonics.samples(1.0f, 4000.0f);
+    EXPECT_TRUE(harmonics.pow(3, 1e-6f).samples(1.0f, 4000.0f).isApprox(base.cube(), tolerance));
+    Wave pow_8 = harmonics.pow(8, 1e-6f);
+    EXPECT_LE(pow_8.num_waves(), 8 * 2 * 64);
+    EXPECT_TRUE(pow_8.samples(1.0f, 4000.0f).isApprox(base.pow(8), tolerance));
+    EXPECT_LE((harmonics ^ 8).num_waves(), pow_8.num_waves());
+    EXPECT_TRUE((harmonics ^ 0) == Wave::one());
+    EXPECT_TRUE((harmonics ^ 1) == harmonics);
+    EXPECT_THROW(harmonics ^ -1, std::invalid_argument);
+    EXPECT_THROW(random_waves[0].pow(8, std::nullopt, 100000), std::length_error);
+}
+
+TEST_F(WaveTest, Sequence) {
+    WaveSeq sequence;
+    sequence.append(Wave::sine(440.0f), 0.5f);
+    sequence.append(random_waves[0], 0.25f);
+    sequence.add(Wave::sine(660.0f), 0.25f, 1.0f, 0.05f);
+    EXPECT_EQ(sequence.num_segments(), 3);
+    EXPECT_FLOAT_EQ(sequence.duration(), 1.0f);
+
+    Eigen::ArrayXf timestamps;
+    Eigen::ArrayXf result = sequence.samples(1.0f, 8000.0f, &timestamps);
+    EXPECT_TRUE(result.isApprox(sequence.samples(timestamps), tolerance));
+
+    Eigen::ArrayXf first = (timestamps < 0.5f).select(Wave::sine(440.0f).samples(timestamps), 0.0f);
+    Eigen::ArrayXf second = (timestamps >= 0.5f && timestamps < 0.75f).select(random_waves[0].samples(timestamps), 0.0f);
+    Eigen::ArrayXf unfaded = result - first - second;
+    Eigen::ArrayXf third = Wave::sine(660.0f).samples(timestamps);
+    EXPECT_TRUE((timestamps < 0.25f).select(unfaded, 0.0f).isZero(tolerance));
+    EXPECT_TRUE((timestamps >= 0.3f && timestamps < 0.95f).select(unfaded - third, 0.0f).isZero(tolerance));
+    EXPECT_THROW(sequence.add(Wave::one(), 1.0f, 0.5f), std::invalid_argument);
+}
+
+TEST_F(WaveTest, Stream) {
+    Wave waves = random_waves[0] + Wave::square(440.0f, 20);
+    WaveStreamF stream(waves, 8000.0f, 500);
+    Eigen::ArrayXf streamed(2000);
+    Eigen::Index offset = 0;
+    stream.pump(2000, [&](const Eigen::ArrayXf& block) {
+        EXPECT_LE(block.size(), 500);
+        streamed.segment(offset, block.size()) = block;
+        offset += block.size();
+    });
+    EXPECT_EQ(stream.position(), 2000);
+    Eigen::ArrayXf timestamps = Eigen::ArrayXf::LinSpaced(2000, 0.0f, 1999.0f / 8000.0f);
+    EXPECT_TRUE(streamed.isApprox(waves.samples(timestamps), tolerance));
+
+    // An hour in, the carried phase still matches a render computed in double
+    Wave tone = Wave::sine(1234.5f);
+    WaveStreamF late_stream(tone, 44100.0f);
+    Eigen::Index late_position = 3600 * 44100;
+    late_stream.seek(late_position);
+    Eigen::ArrayXf late = late_stream.next(64);
+    Eigen::ArrayXd late_timestamps = (Eigen::ArrayXd::LinSpaced(64, 0.0, 63.0) + static_cast<double>(late_position)) / 44100.0;
+    Eigen::ArrayXf expected = (late_timestamps * 1234.5 * 2.0 * std::numbers::pi).sin().cast<float>();
+    EXPECT_TRUE(late.isApprox(expected, tolerance));
+}
+
 TEST_F(WaveTest, Neg_0) { compare_wave_result_with_truth_signal(-random_waves[0], "Neg_0.csv"); }
 TEST_F(WaveTest, Neg_1) { compare_wave_result_with_truth_signal(-random_waves[1], "Neg_1.csv"); }
 TEST_F(WaveTest, Add_0_1) { compare_wave_result_with_truth_signal(random_waves[0] + random_waves[1], "Add_0_1.csv"); }